@@ -0,0 +1,98 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "benchmarks.h"
+
+#include "ui/emoji_config.h"
+
+#include <QtTest/QtTest>
+
+namespace Benchmarks {
+namespace {
+
+constexpr auto kCorpusLength = 64 * 1024;
+
+void AddCorporaRows() {
+	QTest::addColumn<QString>("corpus");
+	for (const auto &name : CorporaNames()) {
+		QTest::newRow(name.toUtf8().constData()) << name;
+	}
+}
+
+} // namespace
+
+class EmojiFind final : public QObject {
+	Q_OBJECT
+
+private Q_SLOTS:
+	// The way the text parser looks for emoji, at every position.
+	void findEverywhere_data() {
+		AddCorporaRows();
+	}
+	void findEverywhere() {
+		QFETCH(QString, corpus);
+		const auto text = CorpusOfLength(corpus, kCorpusLength);
+		QBENCHMARK {
+			auto found = 0;
+			auto ch = text.data();
+			const auto end = ch + text.size();
+			while (ch != end) {
+				auto length = 0;
+				if (Ui::Emoji::Find(ch, end, &length)) {
+					++found;
+					ch += length;
+				} else {
+					++ch;
+				}
+			}
+			Q_UNUSED(found);
+		}
+	}
+
+	// Same as findEverywhere, without skipping the positions
+	// that can't start an emoji before the generated matcher.
+	void findEverywhereUnchecked_data() {
+		AddCorporaRows();
+	}
+	void findEverywhereUnchecked() {
+		QFETCH(QString, corpus);
+		const auto text = CorpusOfLength(corpus, kCorpusLength);
+		QBENCHMARK {
+			auto found = 0;
+			auto ch = text.data();
+			const auto end = ch + text.size();
+			while (ch != end) {
+				auto length = 0;
+				if (Ui::Emoji::internal::Find(ch, end, &length)) {
+					++found;
+					ch += length;
+				} else {
+					++ch;
+				}
+			}
+			Q_UNUSED(found);
+		}
+	}
+
+	void findAll_data() {
+		AddCorporaRows();
+	}
+	void findAll() {
+		QFETCH(QString, corpus);
+		const auto text = CorpusOfLength(corpus, kCorpusLength);
+		QBENCHMARK {
+			auto result = Ui::Emoji::FindAll(text);
+			Q_UNUSED(result);
+		}
+	}
+
+};
+
+LIB_UI_BENCHMARK(EmojiFind)
+
+} // namespace Benchmarks
+
+#include "bench_emoji.moc"
@@ -0,0 +1,102 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "benchmarks.h"
+
+#include "ui/style/style_core_font.h"
+#include "styles/style_basic.h"
+
+#include <QtTest/QtTest>
+
+namespace Benchmarks {
+namespace {
+
+// Short strings like in labels, buttons and menus.
+[[nodiscard]] QStringList Strings(const QString &corpus) {
+	auto result = QStringList();
+	for (const auto &line : Corpus(corpus).split('\n')) {
+		for (auto i = 0; i + 24 <= line.size(); i += 24) {
+			result.push_back(line.mid(i, 24));
+		}
+	}
+	return result;
+}
+
+void AddRows() {
+	QTest::addColumn<QString>("corpus");
+	QTest::addColumn<bool>("semibold");
+	for (const auto &name : { u"links"_q, u"multilingual"_q }) {
+		for (const auto semibold : { false, true }) {
+			const auto row = name.toUtf8()
+				+ (semibold ? "_semibold" : "_normal");
+			QTest::newRow(row.constData()) << name << semibold;
+		}
+	}
+}
+
+} // namespace
+
+class FontMetrics final : public QObject {
+	Q_OBJECT
+
+private Q_SLOTS:
+	void width_data() {
+		AddRows();
+	}
+	void width() {
+		QFETCH(QString, corpus);
+		QFETCH(bool, semibold);
+		const auto font = semibold ? st::semiboldFont : st::normalFont;
+		const auto strings = Strings(corpus);
+		QBENCHMARK {
+			auto sum = 0;
+			for (const auto &string : strings) {
+				sum += font->width(string);
+			}
+			Q_UNUSED(sum);
+		}
+	}
+
+	void widthPart_data() {
+		AddRows();
+	}
+	void widthPart() {
+		QFETCH(QString, corpus);
+		QFETCH(bool, semibold);
+		const auto font = semibold ? st::semiboldFont : st::normalFont;
+		const auto strings = Strings(corpus);
+		QBENCHMARK {
+			auto sum = 0;
+			for (const auto &string : strings) {
+				sum += font->width(string, 4, 12);
+			}
+			Q_UNUSED(sum);
+		}
+	}
+
+	void elided_data() {
+		AddRows();
+	}
+	void elided() {
+		QFETCH(QString, corpus);
+		QFETCH(bool, semibold);
+		const auto font = semibold ? st::semiboldFont : st::normalFont;
+		const auto strings = Strings(corpus);
+		QBENCHMARK {
+			for (const auto &string : strings) {
+				auto result = font->elided(string, 80);
+				Q_UNUSED(result);
+			}
+		}
+	}
+
+};
+
+LIB_UI_BENCHMARK(FontMetrics)
+
+} // namespace Benchmarks
+
+#include "bench_font.moc"
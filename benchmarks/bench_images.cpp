@@ -0,0 +1,158 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "benchmarks.h"
+
+#include "ui/image/image_prepare.h"
+#include "ui/style/style_core.h"
+
+#include <QtGui/QPainter>
+#include <QtTest/QtTest>
+
+#include <random>
+
+namespace Benchmarks {
+namespace {
+
+enum class ImageKind {
+	Photo,
+	Noise,
+	Transparent,
+};
+
+// Generated instead of shipped, so that the sizes are easy to vary:
+// a smooth "photo", a noisy one and an image with an alpha channel.
+[[nodiscard]] QImage GenerateImage(ImageKind kind, QSize size) {
+	auto result = QImage(size, QImage::Format_ARGB32_Premultiplied);
+	switch (kind) {
+	case ImageKind::Photo: {
+		auto p = QPainter(&result);
+		auto gradient = QLinearGradient(0, 0, size.width(), size.height());
+		gradient.setStops({
+			{ 0., QColor(38, 92, 160) },
+			{ 0.5, QColor(240, 190, 120) },
+			{ 1., QColor(60, 120, 70) },
+		});
+		p.fillRect(result.rect(), gradient);
+		p.setPen(Qt::NoPen);
+		for (auto i = 0; i != 32; ++i) {
+			p.setBrush(QColor::fromHsv((i * 37) % 360, 160, 200, 128));
+			p.drawEllipse(
+				(i * 53) % size.width(),
+				(i * 97) % size.height(),
+				size.width() / 5,
+				size.height() / 5);
+		}
+	} break;
+	case ImageKind::Noise: {
+		auto generator = std::mt19937(size.width() * 31 + size.height());
+		auto distribution = std::uniform_int_distribution<uint32>();
+		const auto bits = reinterpret_cast<uint32*>(result.bits());
+		const auto count = result.bytesPerLine() / 4 * result.height();
+		for (auto i = 0; i != count; ++i) {
+			bits[i] = distribution(generator) | 0xFF000000U;
+		}
+	} break;
+	case ImageKind::Transparent: {
+		result.fill(Qt::transparent);
+		auto p = QPainter(&result);
+		p.setRenderHint(QPainter::Antialiasing);
+		p.setPen(Qt::NoPen);
+		p.setBrush(QColor(255, 255, 255, 200));
+		p.drawEllipse(result.rect().marginsRemoved(
+			{ size.width() / 8, size.height() / 8, 0, 0 }));
+	} break;
+	}
+	return result;
+}
+
+void AddImageRows() {
+	QTest::addColumn<int>("kind");
+	QTest::addColumn<QSize>("size");
+	const auto kinds = {
+		std::make_pair(ImageKind::Photo, "photo"),
+		std::make_pair(ImageKind::Noise, "noise"),
+		std::make_pair(ImageKind::Transparent, "transparent"),
+	};
+	for (const auto &[kind, name] : kinds) {
+		for (const auto side : { 64, 320, 1280, 2560 }) {
+			const auto row = QByteArray(name) + '_' + QByteArray::number(side);
+			QTest::newRow(row.constData())
+				<< int(kind)
+				<< QSize(side, side * 3 / 4);
+		}
+	}
+}
+
+} // namespace
+
+class ImageProcessing final : public QObject {
+	Q_OBJECT
+
+private Q_SLOTS:
+	void prepare_data() {
+		AddImageRows();
+	}
+	void prepare() {
+		QFETCH(int, kind);
+		QFETCH(QSize, size);
+		const auto image = GenerateImage(ImageKind(kind), size);
+		const auto target = QSize(320, 240) * style::DevicePixelRatio();
+		QBENCHMARK {
+			auto result = Images::Prepare(image, target, {
+				.options = Images::Option::RoundLarge,
+			});
+			Q_UNUSED(result);
+		}
+	}
+
+	void blur_data() {
+		AddImageRows();
+	}
+	void blur() {
+		QFETCH(int, kind);
+		QFETCH(QSize, size);
+		const auto image = GenerateImage(ImageKind(kind), size);
+		QBENCHMARK {
+			auto result = Images::Blur(QImage(image));
+			Q_UNUSED(result);
+		}
+	}
+
+	void blurLarge_data() {
+		AddImageRows();
+	}
+	void blurLarge() {
+		QFETCH(int, kind);
+		QFETCH(QSize, size);
+		const auto image = GenerateImage(ImageKind(kind), size);
+		QBENCHMARK {
+			auto result = Images::BlurLargeImage(QImage(image), 24);
+			Q_UNUSED(result);
+		}
+	}
+
+	void colorize_data() {
+		AddImageRows();
+	}
+	void colorize() {
+		QFETCH(int, kind);
+		QFETCH(QSize, size);
+		const auto image = GenerateImage(ImageKind(kind), size);
+		const auto color = QColor(90, 160, 230);
+		QBENCHMARK {
+			auto result = style::colorizeImage(image, color);
+			Q_UNUSED(result);
+		}
+	}
+
+};
+
+LIB_UI_BENCHMARK(ImageProcessing)
+
+} // namespace Benchmarks
+
+#include "bench_images.moc"
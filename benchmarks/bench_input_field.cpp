@@ -0,0 +1,82 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "benchmarks.h"
+
+#include "ui/widgets/fields/input_field.h"
+#include "styles/style_widgets.h"
+
+#include <QtWidgets/QTextEdit>
+#include <QtTest/QtTest>
+
+namespace Benchmarks {
+namespace {
+
+constexpr auto kWidth = 320;
+constexpr auto kTypedLength = 160;
+constexpr auto kKeysPerFrame = 4;
+
+void AddCorporaRows() {
+	QTest::addColumn<QString>("corpus");
+	for (const auto &name : CorporaNames()) {
+		QTest::newRow(name.toUtf8().constData()) << name;
+	}
+}
+
+} // namespace
+
+// Types a corpus into a multiline InputField key by key, a display frame
+// after every few keys, then erases it with backspace.
+class InputFieldTyping final : public QObject {
+	Q_OBJECT
+
+private Q_SLOTS:
+	void initTestCase() {
+		_field = std::make_unique<Ui::InputField>(
+			nullptr,
+			st::defaultInputField,
+			Ui::InputField::Mode::MultiLine);
+		_field->resizeToWidth(kWidth);
+		_field->show();
+		_field->setFocus();
+		StepFrames(1);
+	}
+	void cleanupTestCase() {
+		_field = nullptr;
+	}
+
+	void typing_data() {
+		AddCorporaRows();
+	}
+	void typing() {
+		QFETCH(QString, corpus);
+		const auto text = Corpus(corpus).left(kTypedLength);
+		const auto edit = _field->rawTextEdit();
+		QBENCHMARK {
+			for (auto i = 0; i < text.size(); i += kKeysPerFrame) {
+				QTest::keyClicks(edit, text.mid(i, kKeysPerFrame));
+				StepFrames(1);
+			}
+			for (auto i = 0; i < text.size(); i += kKeysPerFrame) {
+				for (auto j = 0; j != kKeysPerFrame; ++j) {
+					QTest::keyClick(edit, Qt::Key_Backspace);
+				}
+				StepFrames(1);
+			}
+			_field->clear();
+		}
+	}
+
+private:
+	std::unique_ptr<Ui::InputField> _field;
+
+};
+
+LIB_UI_BENCHMARK(InputFieldTyping)
+
+} // namespace Benchmarks
+
+#include "bench_input_field.moc"
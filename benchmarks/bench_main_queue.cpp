@@ -0,0 +1,119 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "benchmarks.h"
+
+#include "ui/main_queue_processor.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtTest/QtTest>
+
+#include <crl/crl_on_main.h>
+
+namespace Benchmarks {
+namespace {
+
+constexpr auto kWorkNanoseconds = 50'000;
+
+// Main thread part of a single completion, like publishing a decoded image.
+void Work() {
+	auto timer = QElapsedTimer();
+	timer.start();
+	while (timer.nsecsElapsed() < kWorkNanoseconds) {
+	}
+}
+
+void AddBurstRows() {
+	QTest::addColumn<bool>("lanes");
+	QTest::addColumn<int>("count");
+	for (const auto lanes : { false, true }) {
+		for (const auto count : { 100, 1000 }) {
+			const auto row = QByteArray(lanes ? "lanes_" : "on_main_")
+				+ QByteArray::number(count);
+			QTest::newRow(row.constData()) << lanes << count;
+		}
+	}
+}
+
+void ProcessUntil(const bool &done) {
+	while (!done) {
+		QCoreApplication::processEvents(QEventLoop::AllEvents);
+	}
+}
+
+} // namespace
+
+// A burst of background completions followed by an input-critical item,
+// posted either through crl::on_main() or through the main queue lanes.
+class MainQueueStress final : public QObject {
+	Q_OBJECT
+
+private Q_SLOTS:
+	void inputLatency_data() {
+		AddBurstRows();
+	}
+	void inputLatency() {
+		QFETCH(bool, lanes);
+		QFETCH(int, count);
+		measure(lanes, count, Ui::MainQueueLane::Input);
+	}
+
+	void paintLatency_data() {
+		AddBurstRows();
+	}
+	void paintLatency() {
+		QFETCH(bool, lanes);
+		QFETCH(int, count);
+		measure(lanes, count, Ui::MainQueueLane::Paint);
+	}
+
+private:
+	void measure(bool lanes, int count, Ui::MainQueueLane lane) {
+		auto finished = 0;
+		auto burstDone = false;
+		const auto work = [&] {
+			Work();
+			if (++finished == count) {
+				burstDone = true;
+			}
+		};
+		for (auto i = 0; i != count; ++i) {
+			if (lanes) {
+				Ui::PostToMainQueue(Ui::MainQueueLane::Background, work);
+			} else {
+				crl::on_main(work);
+			}
+		}
+
+		auto timer = QElapsedTimer();
+		timer.start();
+		auto latency = qint64();
+		auto done = false;
+		const auto critical = [&] {
+			latency = timer.nsecsElapsed();
+			done = true;
+		};
+		if (lanes) {
+			Ui::PostToMainQueue(lane, critical);
+		} else {
+			crl::on_main(critical);
+		}
+		ProcessUntil(done);
+		ProcessUntil(burstDone);
+
+		QTest::setBenchmarkResult(
+			latency / 1'000'000.,
+			QTest::WalltimeMilliseconds);
+	}
+
+};
+
+LIB_UI_BENCHMARK(MainQueueStress)
+
+} // namespace Benchmarks
+
+#include "bench_main_queue.moc"
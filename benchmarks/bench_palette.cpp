@@ -0,0 +1,110 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "benchmarks.h"
+
+#include "ui/style/style_core_palette.h"
+#include "ui/widgets/buttons.h"
+#include "ui/widgets/checkbox.h"
+#include "ui/widgets/labels.h"
+#include "ui/wrap/vertical_layout.h"
+#include "ui/qt_object_factory.h"
+#include "ui/rp_widget.h"
+#include "styles/style_widgets.h"
+
+#include <QtTest/QtTest>
+
+namespace Benchmarks {
+namespace {
+
+constexpr auto kRowsCount = 24;
+constexpr auto kWidth = 400;
+constexpr auto kSteps = 20;
+
+// Every color moves, like between a day and a night theme.
+[[nodiscard]] QByteArray InvertedColors(const style::palette &palette) {
+	auto result = palette.save();
+	for (auto i = 0; i != result.size(); i += 4) {
+		for (auto j = i; j != i + 3; ++j) {
+			result[j] = char(255 - uchar(result[j]));
+		}
+	}
+	return result;
+}
+
+} // namespace
+
+class PaletteTransition final : public QObject {
+	Q_OBJECT
+
+private Q_SLOTS:
+	void initTestCase() {
+		_from = *style::main_palette::get();
+		_to.load(InvertedColors(*style::main_palette::get()));
+		_to.finalize();
+
+		_window = std::make_unique<Ui::RpWidget>();
+		const auto layout = Ui::CreateChild<Ui::VerticalLayout>(
+			_window.get());
+		const auto lines = Corpus(u"multilingual"_q).split('\n');
+		for (auto i = 0; i != kRowsCount; ++i) {
+			const auto text = lines[i % lines.size()];
+			layout->add(object_ptr<Ui::FlatLabel>(layout, text));
+			layout->add(object_ptr<Ui::SettingsButton>(
+				layout,
+				rpl::single(text.left(24))));
+			layout->add(object_ptr<Ui::Checkbox>(
+				layout,
+				text.left(16),
+				(i % 2) != 0));
+			layout->add(object_ptr<Ui::RoundButton>(
+				layout,
+				rpl::single(text.left(12)),
+				st::defaultActiveButton));
+		}
+		layout->resizeToWidth(kWidth);
+		_window->resize(kWidth, layout->height());
+		_window->show();
+	}
+	void cleanupTestCase() {
+		style::main_palette::apply(_from);
+		style::NotifyPaletteChanged();
+		_window = nullptr;
+	}
+
+	// One frame of style::main_palette::animateTo() without the timer.
+	void step_data() {
+		QTest::addColumn<bool>("paint");
+		QTest::newRow("colors") << false;
+		QTest::newRow("colors_and_paint") << true;
+	}
+	void step() {
+		QFETCH(bool, paint);
+		auto step = 0;
+		QBENCHMARK {
+			step = (step + 1) % (kSteps + 1);
+			const auto progress = step / float64(kSteps);
+			style::main_palette::interpolate(_from, _to, progress);
+			style::NotifyPaletteChanged();
+			if (paint) {
+				auto result = _window->grab();
+				Q_UNUSED(result);
+			}
+		}
+	}
+
+private:
+	style::palette _from;
+	style::palette _to;
+	std::unique_ptr<Ui::RpWidget> _window;
+
+};
+
+LIB_UI_BENCHMARK(PaletteTransition)
+
+} // namespace Benchmarks
+
+#include "bench_palette.moc"
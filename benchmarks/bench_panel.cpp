@@ -0,0 +1,126 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "benchmarks.h"
+
+#include "ui/effects/panel_animation.h"
+#include "ui/image/image_pool.h"
+#include "ui/image/image_prepare.h"
+#include "ui/widgets/buttons.h"
+#include "ui/wrap/vertical_layout.h"
+#include "ui/rp_widget.h"
+#include "ui/ui_utility.h"
+#include "styles/style_widgets.h"
+
+#include <QtGui/QPainter>
+#include <QtTest/QtTest>
+
+namespace Benchmarks {
+namespace {
+
+constexpr auto kItemsCount = 8;
+constexpr auto kWidth = 240;
+constexpr auto kFramesCount = 15;
+constexpr auto kOpensCount = 20;
+
+void AddPoolRows() {
+	QTest::addColumn<bool>("pooled");
+	QTest::newRow("pool") << true;
+	QTest::newRow("no_pool") << false;
+}
+
+} // namespace
+
+// The PopupMenu show animation: grab the menu, then paint the frames.
+class PanelOpen final : public QObject {
+	Q_OBJECT
+
+private Q_SLOTS:
+	void initTestCase() {
+		_panel = std::make_unique<Ui::VerticalLayout>(nullptr);
+		for (auto i = 0; i != kItemsCount; ++i) {
+			_panel->add(object_ptr<Ui::SettingsButton>(
+				_panel.get(),
+				rpl::single(u"Menu item %1"_q.arg(i + 1))));
+		}
+		_panel->resizeToWidth(kWidth);
+	}
+	void cleanupTestCase() {
+		_panel = nullptr;
+		Images::SetImagePoolLimit(kDefaultPoolLimit);
+	}
+
+	void allocations_data() {
+		AddPoolRows();
+	}
+	void allocations() {
+		QFETCH(bool, pooled);
+		Images::SetImagePoolLimit(pooled ? kDefaultPoolLimit : 0);
+		open(); // Warm up the pool.
+
+		const auto was = Images::ImagePoolStatistics().allocations;
+		for (auto i = 0; i != kOpensCount; ++i) {
+			open();
+		}
+		const auto now = Images::ImagePoolStatistics().allocations;
+		QTest::setBenchmarkResult(
+			qreal(now - was) / kOpensCount,
+			QTest::Events);
+	}
+
+	void time_data() {
+		AddPoolRows();
+	}
+	void time() {
+		QFETCH(bool, pooled);
+		Images::SetImagePoolLimit(pooled ? kDefaultPoolLimit : 0);
+		QBENCHMARK {
+			open();
+		}
+	}
+
+private:
+	static constexpr auto kDefaultPoolLimit = int64(32 * 1024 * 1024);
+
+	void open() {
+		const auto &st = st::defaultPopupMenu;
+		const auto ratio = style::DevicePixelRatio();
+		const auto size = _panel->size();
+		auto animation = Ui::PanelAnimation(
+			st.animation,
+			Ui::PanelAnimation::Origin::TopLeft);
+		animation.setFinalImage(
+			Ui::GrabWidgetToImage(_panel.get()),
+			QRect(QPoint(), size * ratio));
+		animation.setCornerMasks(Images::CornersMask(st.radius));
+		animation.start();
+
+		auto target = QImage(
+			size * ratio,
+			QImage::Format_ARGB32_Premultiplied);
+		target.setDevicePixelRatio(ratio);
+		for (auto i = 1; i <= kFramesCount; ++i) {
+			target.fill(Qt::transparent);
+			auto p = QPainter(&target);
+			animation.paintFrame(
+				p,
+				0,
+				0,
+				size.width(),
+				i / float64(kFramesCount),
+				1.);
+		}
+	}
+
+	std::unique_ptr<Ui::VerticalLayout> _panel;
+
+};
+
+LIB_UI_BENCHMARK(PanelOpen)
+
+} // namespace Benchmarks
+
+#include "bench_panel.moc"
@@ -0,0 +1,135 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "benchmarks.h"
+
+#include "ui/widgets/elastic_scroll.h"
+#include "ui/widgets/labels.h"
+#include "ui/widgets/scroll_area.h"
+#include "ui/wrap/vertical_layout.h"
+#include "styles/style_widgets.h"
+
+#include <QtTest/QtTest>
+
+namespace Benchmarks {
+namespace {
+
+constexpr auto kWidth = 320;
+constexpr auto kHeight = 480;
+constexpr auto kLabelsPerCorpus = 8;
+constexpr auto kNotchesCount = 12;
+constexpr auto kNotch = 120;
+constexpr auto kGestureUpdates = 20;
+constexpr auto kGestureStep = 24;
+constexpr auto kMomentumSteps = 30;
+constexpr auto kReturnFrames = 20;
+
+[[nodiscard]] object_ptr<Ui::VerticalLayout> CreateContent(
+		not_null<QWidget*> parent) {
+	auto result = object_ptr<Ui::VerticalLayout>(parent);
+	for (auto i = 0; i != kLabelsPerCorpus; ++i) {
+		for (const auto &name : CorporaNames()) {
+			result->add(object_ptr<Ui::FlatLabel>(
+				result.data(),
+				Corpus(name)));
+		}
+	}
+	result->resizeToWidth(kWidth);
+	return result;
+}
+
+} // namespace
+
+// Mouse wheel notches down and back in a ScrollArea with labels,
+// each notch followed by a display frame.
+class ScrollAreaWheel final : public QObject {
+	Q_OBJECT
+
+private Q_SLOTS:
+	void initTestCase() {
+		_scroll = std::make_unique<Ui::ScrollArea>(nullptr);
+		_scroll->setOwnedWidget(CreateContent(_scroll.get()));
+		_scroll->resize(kWidth, kHeight);
+		_scroll->show();
+		StepFrames(1);
+	}
+	void cleanupTestCase() {
+		_scroll = nullptr;
+	}
+
+	void wheel() {
+		const auto viewport = _scroll->viewport();
+		QBENCHMARK {
+			for (auto i = 0; i != kNotchesCount; ++i) {
+				SendWheel(viewport, { 0, -kNotch });
+				StepFrames(1);
+			}
+			for (auto i = 0; i != kNotchesCount; ++i) {
+				SendWheel(viewport, { 0, kNotch });
+				StepFrames(1);
+			}
+			_scroll->scrollToY(0);
+		}
+	}
+
+private:
+	std::unique_ptr<Ui::ScrollArea> _scroll;
+
+};
+
+// A touchpad gesture in an ElasticScroll: a phased drag with momentum,
+// then an overscroll above the top and the return animation.
+class ElasticScrollGesture final : public QObject {
+	Q_OBJECT
+
+private Q_SLOTS:
+	void initTestCase() {
+		_scroll = std::make_unique<Ui::ElasticScroll>(nullptr);
+		_scroll->setOwnedWidget(CreateContent(_scroll.get()));
+		_scroll->resize(kWidth, kHeight);
+		_scroll->show();
+		StepFrames(1);
+	}
+	void cleanupTestCase() {
+		_scroll = nullptr;
+	}
+
+	void gesture() {
+		const auto scroll = _scroll.get();
+		QBENCHMARK {
+			drag(-kGestureStep);
+			for (auto i = kMomentumSteps; i != 0; --i) {
+				SendWheel(scroll, { 0, -i }, Qt::ScrollMomentum);
+				StepFrames(1);
+			}
+			drag(kGestureStep);
+			drag(kGestureStep); // Overscroll above the top.
+			StepFrames(kReturnFrames);
+			scroll->scrollToY(0);
+		}
+	}
+
+private:
+	void drag(int step) {
+		const auto scroll = _scroll.get();
+		SendWheel(scroll, {}, Qt::ScrollBegin);
+		for (auto i = 0; i != kGestureUpdates; ++i) {
+			SendWheel(scroll, { 0, step }, Qt::ScrollUpdate);
+			StepFrames(1);
+		}
+		SendWheel(scroll, {}, Qt::ScrollEnd);
+	}
+
+	std::unique_ptr<Ui::ElasticScroll> _scroll;
+
+};
+
+LIB_UI_BENCHMARK(ScrollAreaWheel)
+LIB_UI_BENCHMARK(ElasticScrollGesture)
+
+} // namespace Benchmarks
+
+#include "bench_scroll.moc"
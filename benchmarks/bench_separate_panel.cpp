@@ -0,0 +1,97 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "benchmarks.h"
+
+#include "base/unique_qptr.h"
+#include "ui/widgets/buttons.h"
+#include "ui/widgets/separate_panel.h"
+#include "ui/wrap/vertical_layout.h"
+#include "styles/style_layers.h"
+#include "styles/style_widgets.h"
+
+#include <QtTest/QtTest>
+
+namespace Benchmarks {
+namespace {
+
+constexpr auto kItemsCount = 8;
+constexpr auto kWidth = 320;
+constexpr auto kHeight = 480;
+constexpr auto kRippleFrames = 10;
+
+[[nodiscard]] int AnimationFrames() {
+	return int(st::separatePanelDuration / kFrameDuration) + 2;
+}
+
+} // namespace
+
+// Shows a SeparatePanel with a list of buttons, clicks a button with
+// the mouse and presses a key in it, then hides the panel, stepping
+// the display frames of the opacity and ripple animations.
+class SeparatePanelShow final : public QObject {
+	Q_OBJECT
+
+private Q_SLOTS:
+	void initTestCase() {
+		_panel = std::make_unique<Ui::SeparatePanel>();
+		_panel->setInnerSize({ kWidth, kHeight });
+
+		auto inner = base::make_unique_q<Ui::VerticalLayout>(_panel.get());
+		for (auto i = 0; i != kItemsCount; ++i) {
+			const auto button = inner->add(object_ptr<Ui::SettingsButton>(
+				inner.get(),
+				rpl::single(u"Panel item %1"_q.arg(i + 1))));
+			if (!_button) {
+				_button = button;
+			}
+		}
+		_panel->showInner(std::move(inner));
+		StepFrames(AnimationFrames());
+		hide();
+	}
+	void cleanupTestCase() {
+		_button = nullptr;
+		_panel = nullptr;
+	}
+
+	void show() {
+		QBENCHMARK {
+			_panel->showAndActivate();
+			StepFrames(AnimationFrames());
+			hide();
+		}
+	}
+
+	void input() {
+		_panel->showAndActivate();
+		StepFrames(AnimationFrames());
+		QBENCHMARK {
+			QTest::mouseClick(_button, Qt::LeftButton);
+			StepFrames(kRippleFrames);
+			QTest::keyClick(_panel.get(), Qt::Key_Tab);
+			StepFrames(1);
+		}
+		hide();
+	}
+
+private:
+	void hide() {
+		_panel->hideGetDuration();
+		StepFrames(AnimationFrames());
+		QCoreApplication::sendPostedEvents();
+	}
+
+	std::unique_ptr<Ui::SeparatePanel> _panel;
+	Ui::SettingsButton *_button = nullptr;
+
+};
+
+LIB_UI_BENCHMARK(SeparatePanelShow)
+
+} // namespace Benchmarks
+
+#include "bench_separate_panel.moc"
@@ -0,0 +1,136 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "benchmarks.h"
+
+#include "ui/effects/spoiler_mess.h"
+#include "ui/image/image_prepare.h"
+#include "ui/style/style_core.h"
+
+#include <QtGui/QPainter>
+#include <QtTest/QtTest>
+
+namespace Benchmarks {
+namespace {
+
+// Same as the default text spoiler, but with a fixed seed.
+[[nodiscard]] Ui::SpoilerMessDescriptor TextDescriptor(int particles) {
+	const auto ratio = style::DevicePixelRatio();
+	return {
+		.particleFadeInDuration = crl::time(350),
+		.particleShownDuration = crl::time(200),
+		.particleFadeOutDuration = crl::time(350),
+		.particleSizeMin = style::ConvertScaleExact(1.5) * ratio,
+		.particleSizeMax = style::ConvertScaleExact(2.) * ratio,
+		.particleSpeedMin = style::ConvertScaleExact(2.5),
+		.particleSpeedMax = style::ConvertScaleExact(7.5),
+		.particleSpritesCount = 5,
+		.particlesCount = particles,
+		.canvasSize = style::ConvertScale(128) * ratio,
+		.framesCount = 60,
+		.frameDuration = crl::time(33),
+		.seed = 0x5EED,
+	};
+}
+
+void AddRectRows() {
+	QTest::addColumn<QSize>("size");
+	const auto sizes = {
+		QSize(64, 20),
+		QSize(320, 20),
+		QSize(320, 240),
+		QSize(1280, 720),
+	};
+	for (const auto size : sizes) {
+		const auto row = QByteArray::number(size.width())
+			+ 'x'
+			+ QByteArray::number(size.height());
+		QTest::newRow(row.constData()) << size;
+	}
+}
+
+} // namespace
+
+class SpoilerMess final : public QObject {
+	Q_OBJECT
+
+private Q_SLOTS:
+	void initTestCase() {
+		_cached = std::make_unique<Ui::SpoilerMessCached>(
+			Ui::GenerateSpoilerMess(TextDescriptor(7000)),
+			QColor(255, 255, 255));
+	}
+	void cleanupTestCase() {
+		_cached = nullptr;
+	}
+
+	void generate_data() {
+		QTest::addColumn<int>("particles");
+		for (const auto particles : { 1000, 7000, 20000 }) {
+			QTest::newRow(QByteArray::number(particles).constData())
+				<< particles;
+		}
+	}
+	void generate() {
+		QFETCH(int, particles);
+		const auto descriptor = TextDescriptor(particles);
+		QBENCHMARK {
+			auto result = Ui::GenerateSpoilerMess(descriptor);
+			Q_UNUSED(result);
+		}
+	}
+
+	// Cost of one spoiler frame depending on the spoiler size.
+	void fill_data() {
+		AddRectRows();
+	}
+	void fill() {
+		QFETCH(QSize, size);
+		auto target = QImage(size, QImage::Format_ARGB32_Premultiplied);
+		target.fill(Qt::black);
+		auto index = 0;
+		QBENCHMARK {
+			auto p = QPainter(&target);
+			const auto frame = _cached->frame(index);
+			index = (index + 1) % _cached->framesCount();
+			Ui::FillSpoilerRect(p, target.rect(), frame);
+		}
+	}
+
+	void fillRounded_data() {
+		AddRectRows();
+	}
+	void fillRounded() {
+		QFETCH(QSize, size);
+		auto target = QImage(size, QImage::Format_ARGB32_Premultiplied);
+		target.fill(Qt::black);
+		const auto &mask = Images::CornersMask(
+			std::min({ size.width() / 2, size.height() / 2, 12 }));
+		auto cornerCache = QImage();
+		auto index = 0;
+		QBENCHMARK {
+			auto p = QPainter(&target);
+			const auto frame = _cached->frame(index);
+			index = (index + 1) % _cached->framesCount();
+			Ui::FillSpoilerRect(
+				p,
+				target.rect(),
+				Images::CornersMaskRef(mask),
+				frame,
+				cornerCache);
+		}
+	}
+
+private:
+	std::unique_ptr<Ui::SpoilerMessCached> _cached;
+
+};
+
+LIB_UI_BENCHMARK(SpoilerMess)
+
+} // namespace Benchmarks
+
+#include "bench_spoiler.moc"
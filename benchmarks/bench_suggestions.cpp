@@ -0,0 +1,84 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "benchmarks.h"
+
+#include "emoji_suggestions_helper.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtTest/QtTest>
+
+namespace Benchmarks {
+namespace {
+
+// The alpha codes and aliases the suggestions data is generated from.
+[[nodiscard]] QStringList Vocabulary() {
+	auto file = QFile(QString::fromUtf8(LIB_UI_EMOJI_AUTOCOMPLETE));
+	if (!file.open(QIODevice::ReadOnly)) {
+		qFatal("Could not open the emoji autocomplete vocabulary.");
+	}
+	auto result = QStringList();
+	const auto document = QJsonDocument::fromJson(file.readAll());
+	for (const auto &entry : document.object()) {
+		const auto object = entry.toObject();
+		const auto words = object.value(u"alpha_code"_q).toString()
+			+ '|'
+			+ object.value(u"aliases"_q).toString();
+		result.append(words.split('|', Qt::SkipEmptyParts));
+	}
+	return result;
+}
+
+// Queries the way they grow while the user types the vocabulary words.
+[[nodiscard]] QStringList Keystrokes() {
+	auto result = QStringList();
+	for (auto word : Vocabulary()) {
+		if (word.endsWith(':')) {
+			word.chop(1);
+		}
+		for (auto i = 2; i <= word.size(); ++i) {
+			result.push_back(word.mid(0, i));
+		}
+	}
+	return result;
+}
+
+} // namespace
+
+class EmojiSuggestions final : public QObject {
+	Q_OBJECT
+
+private Q_SLOTS:
+	// One iteration is one keystroke of a ':query' being typed.
+	void keystroke_data() {
+		QTest::addColumn<bool>("incremental");
+		QTest::newRow("full") << false;
+		QTest::newRow("incremental") << true;
+	}
+	void keystroke() {
+		QFETCH(bool, incremental);
+		const auto keystrokes = Keystrokes();
+		auto suggestions = Ui::Emoji::IncrementalSuggestions();
+		auto index = 0;
+		QBENCHMARK {
+			const auto query = Ui::Emoji::QStringToUTF16(keystrokes[index]);
+			index = (index + 1) % keystrokes.size();
+			auto result = incremental
+				? suggestions.get(query)
+				: Ui::Emoji::GetSuggestions(query);
+			Q_UNUSED(result);
+		}
+	}
+
+};
+
+LIB_UI_BENCHMARK(EmojiSuggestions)
+
+} // namespace Benchmarks
+
+#include "bench_suggestions.moc"
@@ -0,0 +1,120 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "benchmarks.h"
+
+#include "ui/text/text.h"
+#include "ui/text/text_entity.h"
+#include "styles/style_basic.h"
+
+#include <QtTest/QtTest>
+
+namespace Benchmarks {
+namespace {
+
+constexpr auto kHoverPathLength = 64;
+constexpr auto kAllEntities = TextParseLinks
+	| TextParseMentions
+	| TextParseHashtags
+	| TextParseBotCommands
+	| TextParseMarkdown;
+
+void AddCorporaRows() {
+	QTest::addColumn<QString>("corpus");
+	for (const auto &name : CorporaNames()) {
+		QTest::newRow(name.toUtf8().constData()) << name;
+	}
+}
+
+} // namespace
+
+class TextLayout final : public QObject {
+	Q_OBJECT
+
+private Q_SLOTS:
+	void parse_data() {
+		AddCorporaRows();
+	}
+	void parse() {
+		QFETCH(QString, corpus);
+		const auto text = Corpus(corpus);
+		QBENCHMARK {
+			auto string = Ui::Text::String(
+				st::defaultTextStyle,
+				TextWithEntities{ text },
+				kMarkupTextOptions);
+			Q_UNUSED(string);
+		}
+	}
+
+	void countHeight_data() {
+		AddCorporaRows();
+	}
+	void countHeight() {
+		QFETCH(QString, corpus);
+		const auto string = Ui::Text::String(
+			st::defaultTextStyle,
+			TextWithEntities{ Corpus(corpus) },
+			kMarkupTextOptions);
+		auto width = 200;
+		QBENCHMARK {
+			// Different widths, so that nothing is cached between runs.
+			width = (width < 600) ? (width + 7) : 200;
+			const auto height = string.countHeight(width);
+			Q_UNUSED(height);
+		}
+	}
+
+	// Mouse moves over a text of different length, the way FlatLabel
+	// looks up the link under the cursor on every move.
+	void hover_data() {
+		QTest::addColumn<int>("length");
+		for (const auto length : { 256, 1024, 4096, 16384 }) {
+			QTest::newRow(QByteArray::number(length).constData()) << length;
+		}
+	}
+	void hover() {
+		QFETCH(int, length);
+		const auto string = Ui::Text::String(
+			st::defaultTextStyle,
+			TextWithEntities{ CorpusOfLength(u"links"_q, length) },
+			kMarkupTextOptions);
+		const auto width = 400;
+		const auto height = string.countHeight(width);
+		auto path = std::vector<QPoint>();
+		for (auto i = 0; i != kHoverPathLength; ++i) {
+			path.push_back({
+				(i * 37) % width,
+				int(int64(i) * height / kHoverPathLength),
+			});
+		}
+		QBENCHMARK {
+			for (const auto point : path) {
+				const auto state = string.getState(point, width);
+				Q_UNUSED(state);
+			}
+		}
+	}
+
+	void parseEntities_data() {
+		AddCorporaRows();
+	}
+	void parseEntities() {
+		QFETCH(QString, corpus);
+		const auto text = Corpus(corpus);
+		QBENCHMARK {
+			auto result = TextUtilities::ParseEntities(text, kAllEntities);
+			Q_UNUSED(result);
+		}
+	}
+
+};
+
+LIB_UI_BENCHMARK(TextLayout)
+
+} // namespace Benchmarks
+
+#include "bench_text.moc"
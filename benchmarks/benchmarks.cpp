@@ -0,0 +1,258 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "benchmarks.h"
+
+#include "base/integration.h"
+#include "ui/effects/animations.h"
+#include "ui/effects/frame_clock.h"
+#include "ui/style/style_core.h"
+#include "ui/style/style_core_font.h"
+#include "ui/emoji_config.h"
+#include "ui/integration.h"
+#include "ui/main_queue_processor.h"
+#include "ui/paint/paint_profiler.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QStandardPaths>
+#include <QtGui/QWheelEvent>
+#include <QtTest/QtTest>
+#include <QtWidgets/QApplication>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace Benchmarks {
+namespace {
+
+std::atomic<int64> Allocations = 0;
+Ui::Animations::ManualFrameClock *ClockInstance = nullptr;
+
+struct Entry {
+	const char *name = nullptr;
+	Factory factory = nullptr;
+};
+
+[[nodiscard]] std::vector<Entry> &Registered() {
+	static auto result = std::vector<Entry>();
+	return result;
+}
+
+class BaseIntegration final : public base::Integration {
+public:
+	using base::Integration::Integration;
+
+	void enterFromEventLoop(FnMut<void()> &&method) override {
+		method();
+	}
+	bool logSkipDebug() override {
+		return true;
+	}
+	void logMessageDebug(const QString &message) override {
+	}
+	void logMessage(const QString &message) override {
+		qWarning("%s", message.toUtf8().constData());
+	}
+
+};
+
+class UiIntegration final : public Ui::Integration {
+public:
+	void postponeCall(FnMut<void()> &&callable) override {
+		crl::on_main(std::move(callable));
+	}
+	void registerLeaveSubscription(not_null<QWidget*> widget) override {
+	}
+	void unregisterLeaveSubscription(not_null<QWidget*> widget) override {
+	}
+
+	QString emojiCacheFolder() override {
+		return QStandardPaths::writableLocation(
+			QStandardPaths::TempLocation) + u"/lib_ui_benchmarks"_q;
+	}
+	QString openglCheckFilePath() override {
+		return emojiCacheFolder() + u"/opengl"_q;
+	}
+	QString angleBackendFilePath() override {
+		return emojiCacheFolder() + u"/angle"_q;
+	}
+
+};
+
+// "-results <folder>" writes <folder>/<benchmark>.xml for each benchmark,
+// "-paint-profile <folder>" writes <folder>/<benchmark>.json paint traces,
+// all other arguments are passed to QTest as is.
+[[nodiscard]] int RunAll(const QStringList &arguments) {
+	auto results = QString();
+	auto profiles = QString();
+	auto only = QStringList();
+	auto passed = QStringList{ arguments.value(0) };
+	for (auto i = 1; i < arguments.size(); ++i) {
+		if (arguments[i] == u"-results"_q && i + 1 < arguments.size()) {
+			results = arguments[++i];
+		} else if (arguments[i] == u"-paint-profile"_q
+			&& i + 1 < arguments.size()) {
+			profiles = arguments[++i];
+		} else if (arguments[i] == u"-only"_q && i + 1 < arguments.size()) {
+			only.push_back(arguments[++i]);
+		} else {
+			passed.push_back(arguments[i]);
+		}
+	}
+	if (!results.isEmpty()) {
+		QDir().mkpath(results);
+	}
+	if (!profiles.isEmpty()) {
+		QDir().mkpath(profiles);
+	}
+	auto failed = 0;
+	for (const auto &entry : Registered()) {
+		const auto name = QString::fromLatin1(entry.name);
+		if (!only.isEmpty() && !only.contains(name)) {
+			continue;
+		}
+		auto list = passed;
+		if (!results.isEmpty()) {
+			list.push_back(u"-o"_q);
+			list.push_back(results + '/' + name + u".xml,xml"_q);
+			list.push_back(u"-o"_q);
+			list.push_back(u"-,txt"_q);
+		}
+		const auto object = entry.factory();
+		if (!profiles.isEmpty()) {
+			Ui::StartPaintProfiling();
+		}
+		failed += QTest::qExec(object.get(), list) ? 1 : 0;
+		if (!profiles.isEmpty()) {
+			Ui::StopPaintProfiling();
+			auto file = QFile(profiles + '/' + name + u".json"_q);
+			if (file.open(QIODevice::WriteOnly)) {
+				file.write(Ui::PaintProfilingJson());
+			}
+		}
+	}
+	return failed;
+}
+
+} // namespace
+
+Registration::Registration(const char *name, Factory factory) {
+	Registered().push_back({ name, factory });
+}
+
+QString Corpus(const QString &name) {
+	auto file = QFile(
+		QString::fromUtf8(LIB_UI_BENCHMARKS_CORPORA) + '/' + name + u".txt"_q);
+	if (!file.open(QIODevice::ReadOnly)) {
+		qFatal("Could not open corpus '%s'.", name.toUtf8().constData());
+	}
+	return QString::fromUtf8(file.readAll());
+}
+
+QStringList CorporaNames() {
+	return {
+		u"multilingual"_q,
+		u"rtl"_q,
+		u"emoji"_q,
+		u"links"_q,
+	};
+}
+
+int64 AllocationsCount() {
+	return Allocations.load(std::memory_order_relaxed);
+}
+
+Ui::Animations::ManualFrameClock &Clock() {
+	Expects(ClockInstance != nullptr);
+
+	return *ClockInstance;
+}
+
+void StepFrames(int count) {
+	for (auto i = 0; i != count; ++i) {
+		Clock().advance(kFrameDuration);
+		QCoreApplication::sendPostedEvents();
+	}
+}
+
+void SendWheel(
+		not_null<QWidget*> widget,
+		QPoint delta,
+		Qt::ScrollPhase phase) {
+	const auto position = QPointF(widget->rect().center());
+	const auto touchpad = (phase != Qt::NoScrollPhase);
+	auto event = QWheelEvent(
+		position,
+		QPointF(widget->mapToGlobal(position.toPoint())),
+		touchpad ? delta : QPoint(),
+		delta,
+		Qt::NoButton,
+		Qt::NoModifier,
+		phase,
+		false);
+	QCoreApplication::sendEvent(widget, &event);
+}
+
+QString CorpusOfLength(const QString &name, int length) {
+	const auto corpus = Corpus(name);
+	auto result = QString();
+	result.reserve(length + corpus.size());
+	while (result.size() < length) {
+		result.append(corpus);
+	}
+	return result;
+}
+
+} // namespace Benchmarks
+
+void *operator new(std::size_t size) {
+	Benchmarks::Allocations.fetch_add(1, std::memory_order_relaxed);
+	if (const auto result = std::malloc(size ? size : 1)) {
+		return result;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t size) noexcept {
+	std::free(pointer);
+}
+
+int main(int argc, char *argv[]) {
+	if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	}
+	auto base = Benchmarks::BaseIntegration(argc, argv);
+	base::Integration::Set(&base);
+
+	auto application = QApplication(argc, argv);
+	auto integration = Benchmarks::UiIntegration();
+	Ui::Integration::Set(&integration);
+	auto processor = Ui::MainQueueProcessor();
+	Ui::SetPaintProfilingAllocationsCounter(Benchmarks::AllocationsCount);
+
+	style::internal::StartFonts();
+	style::StartManager(style::kScaleDefault);
+	Ui::Emoji::Init();
+
+	auto animations = Ui::Animations::Manager();
+	auto clock = std::make_unique<Ui::Animations::ManualFrameClock>(
+		crl::now());
+	Benchmarks::ClockInstance = clock.get();
+	animations.setFrameClock(std::move(clock));
+
+	const auto result = Benchmarks::RunAll(application.arguments());
+
+	Benchmarks::ClockInstance = nullptr;
+	Ui::Emoji::Clear();
+	style::StopManager();
+	return result;
+}
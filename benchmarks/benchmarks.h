@@ -0,0 +1,63 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+#include <crl/crl_time.h>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+
+#include <memory>
+
+class QWidget;
+
+namespace Ui::Animations {
+class ManualFrameClock;
+} // namespace Ui::Animations
+
+namespace Benchmarks {
+
+using Factory = std::unique_ptr<QObject>(*)();
+
+struct Registration {
+	Registration(const char *name, Factory factory);
+};
+
+// Text corpus from the 'corpora' folder, without the '.txt' extension.
+[[nodiscard]] QString Corpus(const QString &name);
+[[nodiscard]] QStringList CorporaNames();
+
+// Repeats the corpus until it has at least 'length' characters.
+[[nodiscard]] QString CorpusOfLength(const QString &name, int length);
+
+// Count of global operator new calls since the start, from all threads.
+[[nodiscard]] int64 AllocationsCount();
+
+// The clock of the Animations::Manager, it moves only by advance().
+[[nodiscard]] Ui::Animations::ManualFrameClock &Clock();
+
+inline constexpr auto kFrameDuration = crl::time(16);
+
+// Advances the clock by 'count' display frames, delivering the posted
+// events (repaints, postponed calls) after each one.
+void StepFrames(int count);
+
+// Sends a scripted wheel event to 'widget'. Without a phase it is a mouse
+// wheel with 'delta' in 1/8 degree (120 per notch), with a phase it is
+// a touchpad gesture with 'delta' in pixels.
+void SendWheel(
+	not_null<QWidget*> widget,
+	QPoint delta,
+	Qt::ScrollPhase phase = Qt::NoScrollPhase);
+
+} // namespace Benchmarks
+
+#define LIB_UI_BENCHMARK(Class) \
+	static const auto Class##Registration = ::Benchmarks::Registration( \
+		#Class, \
+		[]() -> std::unique_ptr<QObject> { \
+			return std::make_unique<Class>(); \
+		});
@@ -108,7 +108,10 @@ class Completer {
 public:
 	Completer(utf16string query);
 
-	std::vector<Suggestion> resolve();
+	const std::vector<utf16char> &query() const;
+	std::vector<Suggestion> resolve(
+		const std::vector<const Replacement*> *candidates = nullptr);
+	std::vector<const Replacement*> takeMatched();
 
 private:
 	struct Result {
@@ -139,6 +142,7 @@ private:
 	int _querySize = 0;
 
 	const std::vector<const Replacement*> *_initialList = nullptr;
+	std::vector<const Replacement*> _matched;
 
 	string_span _currentItemWords;
 	int _currentItemWordsUsedCount = 0;
@@ -219,13 +223,23 @@ std::vector<utf16char> Completer::NormalizeQuery(utf16string query) {
 	return result;
 }
 
-std::vector<Suggestion> Completer::resolve() {
+const std::vector<utf16char> &Completer::query() const {
+	return _query;
+}
+
+std::vector<Suggestion> Completer::resolve(
+		const std::vector<const Replacement*> *candidates) {
 	_queryBegin = _query.data();
 	_querySize = _query.size();
 	if (!_querySize) {
 		return std::vector<Suggestion>();
 	}
-	_initialList = internal::GetReplacements(*_queryBegin);
+
+	// Candidates are the replacements matching a prefix of the query,
+	// they keep the order of the list, so the result is the same.
+	_initialList = candidates
+		? candidates
+		: internal::GetReplacements(*_queryBegin);
 	if (!_initialList) {
 		return std::vector<Suggestion>();
 	}
@@ -234,6 +248,10 @@ std::vector<Suggestion> Completer::resolve() {
 	return prepareResult();
 }
 
+std::vector<const Replacement*> Completer::takeMatched() {
+	return std::move(_matched);
+}
+
 bool Completer::isDuplicateOfLastResult(const Replacement *item) const {
 	if (_result.empty()) {
 		return false;
@@ -272,6 +290,7 @@ void Completer::processInitialList() {
 		for (auto item : *_initialList) {
 			addResult(item);
 		}
+		_matched = *_initialList;
 	}
 }
 
@@ -293,6 +312,7 @@ void Completer::filterInitialList() {
 		_currentItemWordsUsedCount = 1;
 		if (matchQueryForCurrentItem()) {
 			addResult(item);
+			_matched.push_back(item);
 		}
 		_currentItemWordsUsedCount = 0;
 	}
@@ -425,6 +445,28 @@ std::vector<Suggestion> GetSuggestions(utf16string query) {
 	return Completer(query).resolve();
 }
 
+std::vector<Suggestion> IncrementalSuggestions::get(utf16string query) {
+	auto completer = Completer(query);
+	const auto &normalized = completer.query();
+
+	// An item matching the query also matches any prefix of it.
+	const auto refine = !query_.empty()
+		&& (normalized.size() >= query_.size())
+		&& std::equal(
+			std::begin(query_),
+			std::end(query_),
+			std::begin(normalized));
+	auto result = completer.resolve(refine ? &matched_ : nullptr);
+	matched_ = completer.takeMatched();
+	query_ = normalized;
+	return result;
+}
+
+void IncrementalSuggestions::clear() {
+	query_.clear();
+	matched_.clear();
+}
+
 int GetSuggestionMaxLength() {
 	return internal::kReplacementMaxLength;
 }
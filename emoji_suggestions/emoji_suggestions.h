@@ -51,6 +51,8 @@ namespace internal {
 using checksum = unsigned int;
 checksum countChecksum(const void *data, std::size_t size);
 
+struct Replacement;
+
 utf16string GetReplacementEmoji(utf16string replacement);
 
 } // namespace internal
@@ -82,6 +84,19 @@ private:
 
 std::vector<Suggestion> GetSuggestions(utf16string query);
 
+// Same results as GetSuggestions(), but when the query extends the previous
+// one only the replacements that matched the previous query are checked.
+class IncrementalSuggestions {
+public:
+	std::vector<Suggestion> get(utf16string query);
+	void clear();
+
+private:
+	std::vector<utf16char> query_;
+	std::vector<const internal::Replacement*> matched_;
+
+};
+
 inline utf16string GetSuggestionEmoji(utf16string replacement) {
 	return internal::GetReplacementEmoji(replacement);
 }
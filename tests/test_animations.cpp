@@ -0,0 +1,79 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "tests.h"
+
+#include "ui/effects/animations.h"
+#include "ui/effects/frame_clock.h"
+
+#include <QtTest/QtTest>
+
+namespace Tests {
+
+// Animations tick only from ManualFrameClock::advance(),
+// without any event loop turns in between.
+class AnimationsClock final : public QObject {
+	Q_OBJECT
+
+private Q_SLOTS:
+	void simpleLinear() {
+		auto &clock = Clock();
+		auto values = std::vector<float64>();
+		auto animation = Ui::Animations::Simple();
+		animation.start([&](float64 value) {
+			values.push_back(value);
+		}, 0., 100., 200);
+		QVERIFY(animation.animating());
+		QVERIFY(clock.requested());
+		QCOMPARE(animation.value(100.), 0.);
+
+		clock.advance(50);
+		QCOMPARE(animation.value(100.), 25.);
+		clock.advance(50);
+		QCOMPARE(animation.value(100.), 50.);
+		clock.advance(150);
+		QVERIFY(!animation.animating());
+		QCOMPARE(animation.value(100.), 100.);
+		QCOMPARE(values, (std::vector<float64>{ 25., 50., 100. }));
+		QVERIFY(!clock.requested());
+	}
+
+	void simpleChange() {
+		auto &clock = Clock();
+		auto animation = Ui::Animations::Simple();
+		animation.start([] {}, 0., 100., 100);
+		clock.advance(50);
+		QCOMPARE(animation.value(100.), 50.);
+
+		animation.change(0., 100);
+		clock.advance(50);
+		QCOMPARE(animation.value(0.), 25.);
+		clock.advance(50);
+		QVERIFY(!animation.animating());
+		QCOMPARE(animation.value(0.), 0.);
+	}
+
+	void basicStopsOnFalse() {
+		auto &clock = Clock();
+		auto ticks = 0;
+		auto animation = Ui::Animations::Basic([&] {
+			return (++ticks < 3);
+		});
+		animation.start();
+		for (auto i = 0; i != 5; ++i) {
+			clock.advance(16);
+		}
+		QCOMPARE(ticks, 3);
+		QVERIFY(!animation.animating());
+	}
+
+};
+
+LIB_UI_TEST(AnimationsClock)
+
+} // namespace Tests
+
+#include "test_animations.moc"
@@ -0,0 +1,81 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "tests.h"
+
+#include "emoji_suggestions_helper.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtTest/QtTest>
+
+namespace Tests {
+namespace {
+
+// The alpha codes and aliases the suggestions data is generated from.
+[[nodiscard]] QStringList Vocabulary() {
+	auto file = QFile(QString::fromUtf8(LIB_UI_EMOJI_AUTOCOMPLETE));
+	if (!file.open(QIODevice::ReadOnly)) {
+		qFatal("Could not open the emoji autocomplete vocabulary.");
+	}
+	auto result = QStringList();
+	const auto document = QJsonDocument::fromJson(file.readAll());
+	for (const auto &entry : document.object()) {
+		const auto object = entry.toObject();
+		const auto words = object.value(u"alpha_code"_q).toString()
+			+ '|'
+			+ object.value(u"aliases"_q).toString();
+		result.append(words.split('|', Qt::SkipEmptyParts));
+	}
+	return result;
+}
+
+[[nodiscard]] QStringList Serialize(
+		const std::vector<Ui::Emoji::Suggestion> &suggestions) {
+	using Ui::Emoji::QStringFromUTF16;
+	auto result = QStringList();
+	for (const auto &suggestion : suggestions) {
+		result.push_back(QStringFromUTF16(suggestion.emoji())
+			+ ' '
+			+ QStringFromUTF16(suggestion.label())
+			+ ' '
+			+ QStringFromUTF16(suggestion.replacement()));
+	}
+	return result;
+}
+
+} // namespace
+
+// IncrementalSuggestions refines the previous results while a query
+// grows, it should find exactly what GetSuggestions() finds.
+class EmojiSuggestionsMatch final : public QObject {
+	Q_OBJECT
+
+private Q_SLOTS:
+	void vocabulary() {
+		const auto words = Vocabulary();
+		QVERIFY(!words.isEmpty());
+
+		auto suggestions = Ui::Emoji::IncrementalSuggestions();
+		for (const auto &word : words) {
+			for (auto i = 1; i <= word.size(); ++i) {
+				const auto query = word.mid(0, i);
+				const auto utf16 = Ui::Emoji::QStringToUTF16(query);
+				const auto incremental = Serialize(suggestions.get(utf16));
+				const auto full = Serialize(Ui::Emoji::GetSuggestions(utf16));
+				QVERIFY2(incremental == full, query.toUtf8().constData());
+			}
+		}
+	}
+
+};
+
+LIB_UI_TEST(EmojiSuggestionsMatch)
+
+} // namespace Tests
+
+#include "test_emoji_suggestions.moc"
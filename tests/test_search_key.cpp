@@ -0,0 +1,74 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "tests.h"
+
+#include "ui/text/text_entity.h"
+
+#include <QtTest/QtTest>
+
+namespace Tests {
+
+// SearchKey queries match the same as PrepareSearchWords() ones.
+class SearchKeyMatch final : public QObject {
+	Q_OBJECT
+
+private Q_SLOTS:
+	void removeAccents() {
+		QCOMPARE(
+			TextUtilities::RemoveAccents(u"plain ascii"_q),
+			u"plain ascii"_q);
+		QCOMPARE(
+			TextUtilities::RemoveAccents(
+				QString::fromUtf8("\xc3\x85ngstr\xc3\xb6m caf\xc3\xa9")),
+			u"angstrom cafe"_q);
+		QCOMPARE(
+			TextUtilities::RemoveAccents(
+				QString::fromUtf8("\xd1\x91\xd0\xb6")),
+			QString::fromUtf8("\xd0\xb5\xd0\xb6"));
+	}
+
+	void queryKey_data() {
+		QTest::addColumn<QString>("text");
+		QTest::addColumn<QString>("query");
+		const auto texts = {
+			QString::fromUtf8("Ren\xc3\xa9 Descartes"),
+			u"Isaac Newton"_q,
+			QString::fromUtf8("\xd0\x9b\xd0\xb5\xd0\xb2 \xd0\xa2\xd0\xbe"
+				"\xd0\xbb\xd1\x81\xd1\x82\xd0\xbe\xd0\xb9"),
+		};
+		const auto queries = {
+			u"rene"_q,
+			u"  desc  ren "_q,
+			u"isaac newt"_q,
+			u"newton isaac x"_q,
+			QString::fromUtf8("\xd1\x82\xd0\xbe\xd0\xbb"),
+			u""_q,
+		};
+		auto index = 0;
+		for (const auto &text : texts) {
+			for (const auto &query : queries) {
+				const auto row = QByteArray::number(++index);
+				QTest::newRow(row.constData()) << text << query;
+			}
+		}
+	}
+	void queryKey() {
+		QFETCH(QString, text);
+		QFETCH(QString, query);
+		const auto key = TextUtilities::SearchKey(text);
+		QCOMPARE(
+			key.matches(TextUtilities::SearchKey(query)),
+			key.matches(TextUtilities::PrepareSearchWords(query)));
+	}
+
+};
+
+LIB_UI_TEST(SearchKeyMatch)
+
+} // namespace Tests
+
+#include "test_search_key.moc"
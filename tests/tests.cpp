@@ -0,0 +1,140 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "tests.h"
+
+#include "base/integration.h"
+#include "ui/effects/animations.h"
+#include "ui/effects/frame_clock.h"
+#include "ui/style/style_core.h"
+#include "ui/style/style_core_font.h"
+#include "ui/integration.h"
+#include "ui/main_queue_processor.h"
+
+#include <QtCore/QStandardPaths>
+#include <QtTest/QtTest>
+#include <QtWidgets/QApplication>
+
+namespace Tests {
+namespace {
+
+struct Entry {
+	const char *name = nullptr;
+	Factory factory = nullptr;
+};
+
+Ui::Animations::ManualFrameClock *ClockInstance = nullptr;
+
+[[nodiscard]] std::vector<Entry> &Registered() {
+	static auto result = std::vector<Entry>();
+	return result;
+}
+
+class BaseIntegration final : public base::Integration {
+public:
+	using base::Integration::Integration;
+
+	void enterFromEventLoop(FnMut<void()> &&method) override {
+		method();
+	}
+	bool logSkipDebug() override {
+		return true;
+	}
+	void logMessageDebug(const QString &message) override {
+	}
+	void logMessage(const QString &message) override {
+		qWarning("%s", message.toUtf8().constData());
+	}
+
+};
+
+class UiIntegration final : public Ui::Integration {
+public:
+	void postponeCall(FnMut<void()> &&callable) override {
+		crl::on_main(std::move(callable));
+	}
+	void registerLeaveSubscription(not_null<QWidget*> widget) override {
+	}
+	void unregisterLeaveSubscription(not_null<QWidget*> widget) override {
+	}
+
+	QString emojiCacheFolder() override {
+		return QStandardPaths::writableLocation(
+			QStandardPaths::TempLocation) + u"/lib_ui_tests"_q;
+	}
+	QString openglCheckFilePath() override {
+		return emojiCacheFolder() + u"/opengl"_q;
+	}
+	QString angleBackendFilePath() override {
+		return emojiCacheFolder() + u"/angle"_q;
+	}
+
+};
+
+// "-only <Class>" limits the run,
+// all other arguments are passed to QTest as is.
+[[nodiscard]] int RunAll(const QStringList &arguments) {
+	auto only = QStringList();
+	auto passed = QStringList{ arguments.value(0) };
+	for (auto i = 1; i < arguments.size(); ++i) {
+		if (arguments[i] == u"-only"_q && i + 1 < arguments.size()) {
+			only.push_back(arguments[++i]);
+		} else {
+			passed.push_back(arguments[i]);
+		}
+	}
+	auto failed = 0;
+	for (const auto &entry : Registered()) {
+		const auto name = QString::fromLatin1(entry.name);
+		if (!only.isEmpty() && !only.contains(name)) {
+			continue;
+		}
+		const auto object = entry.factory();
+		failed += QTest::qExec(object.get(), passed) ? 1 : 0;
+	}
+	return failed;
+}
+
+} // namespace
+
+Registration::Registration(const char *name, Factory factory) {
+	Registered().push_back({ name, factory });
+}
+
+Ui::Animations::ManualFrameClock &Clock() {
+	Expects(ClockInstance != nullptr);
+
+	return *ClockInstance;
+}
+
+} // namespace Tests
+
+int main(int argc, char *argv[]) {
+	if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	}
+	auto base = Tests::BaseIntegration(argc, argv);
+	base::Integration::Set(&base);
+
+	auto application = QApplication(argc, argv);
+	auto integration = Tests::UiIntegration();
+	Ui::Integration::Set(&integration);
+	auto processor = Ui::MainQueueProcessor();
+
+	style::internal::StartFonts();
+	style::StartManager(style::kScaleDefault);
+
+	auto animations = Ui::Animations::Manager();
+	auto clock = std::make_unique<Ui::Animations::ManualFrameClock>();
+	Tests::ClockInstance = clock.get();
+	animations.setFrameClock(std::move(clock));
+
+	const auto result = Tests::RunAll(application.arguments());
+
+	Tests::ClockInstance = nullptr;
+	style::StopManager();
+	return result;
+}
@@ -0,0 +1,35 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+#include <QtCore/QObject>
+
+#include <memory>
+
+namespace Ui::Animations {
+class ManualFrameClock;
+} // namespace Ui::Animations
+
+namespace Tests {
+
+using Factory = std::unique_ptr<QObject>(*)();
+
+struct Registration {
+	Registration(const char *name, Factory factory);
+};
+
+// The clock of the Animations::Manager, it moves only by advance().
+[[nodiscard]] Ui::Animations::ManualFrameClock &Clock();
+
+} // namespace Tests
+
+#define LIB_UI_TEST(Class) \
+	static const auto Class##Registration = ::Tests::Registration( \
+		#Class, \
+		[]() -> std::unique_ptr<QObject> { \
+			return std::make_unique<Class>(); \
+		});
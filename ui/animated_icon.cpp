@@ -9,16 +9,187 @@
 #include "ui/image/image_prepare.h"
 #include "ui/style/style_core.h"
 #include "ui/effects/frame_generator.h"
+#include "ui/main_queue_processor.h"
 
 #include <QtGui/QPainter>
 #include <crl/crl_async.h>
 #include <crl/crl_semaphore.h>
 #include <crl/crl_on_main.h>
+#include <xxhash.h>
+
+#include <list>
+#include <mutex>
 
 namespace Ui {
 namespace {
 
 constexpr auto kDefaultDuration = crl::time(800);
+constexpr auto kDefaultCacheLimit = int64(16 * 1024 * 1024);
+
+struct CachedIconInfo {
+	QSize desiredSize;
+	int framesCount = 0;
+	double frameRate = 0.;
+};
+
+// Decoded, not yet colorized frames, shared between icon instances.
+// Accessed both from the main thread and from crl::async.
+class FramesCache final {
+public:
+	void setLimit(int64 bytes);
+
+	[[nodiscard]] std::optional<CachedIconInfo> info(
+		const QString &key,
+		QSize sizeOverride);
+	void setInfo(
+		const QString &key,
+		QSize sizeOverride,
+		const CachedIconInfo &info);
+
+	// Frames are keyed by the size requested from the generator,
+	// the frame image itself may have a different one.
+	[[nodiscard]] std::optional<FrameGenerator::Frame> frame(
+		const QString &key,
+		int index,
+		QSize requested);
+	void setFrame(
+		const QString &key,
+		int index,
+		QSize requested,
+		const FrameGenerator::Frame &frame);
+
+private:
+	struct Key {
+		QString source;
+		int width = 0;
+		int height = 0;
+		int index = 0;
+
+		friend inline bool operator<(const Key &a, const Key &b) {
+			return (a.source < b.source)
+				|| (a.source == b.source
+					&& std::tie(a.width, a.height, a.index)
+						< std::tie(b.width, b.height, b.index));
+		}
+	};
+	struct Entry {
+		FrameGenerator::Frame frame;
+		std::list<Key>::iterator used;
+	};
+
+	void evict();
+
+	std::mutex _mutex;
+	base::flat_map<Key, CachedIconInfo> _infos;
+	base::flat_map<Key, Entry> _frames;
+	std::list<Key> _used; // From the least to the most recently used.
+	int64 _bytes = 0;
+	int64 _limit = kDefaultCacheLimit;
+
+};
+
+[[nodiscard]] FramesCache &Cache() {
+	static auto result = FramesCache();
+	return result;
+}
+
+[[nodiscard]] QString ComputeCacheKey(
+		const AnimatedIconDescriptor &descriptor) {
+	const auto &source = descriptor.source;
+	if (!descriptor.cacheKey.isEmpty() || source.isEmpty()) {
+		return descriptor.cacheKey;
+	}
+	const auto hash = XXH64(source.constData(), source.size(), 0);
+	return u"source:%1:%2"_q.arg(hash, 16, 16, QChar('0')).arg(source.size());
+}
+
+void FramesCache::setLimit(int64 bytes) {
+	auto lock = std::unique_lock(_mutex);
+	_limit = std::max(bytes, int64(0));
+	evict();
+}
+
+std::optional<CachedIconInfo> FramesCache::info(
+		const QString &key,
+		QSize sizeOverride) {
+	auto lock = std::unique_lock(_mutex);
+	const auto i = _infos.find(Key{
+		key,
+		sizeOverride.width(),
+		sizeOverride.height(),
+	});
+	return (i != end(_infos))
+		? std::make_optional(i->second)
+		: std::nullopt;
+}
+
+void FramesCache::setInfo(
+		const QString &key,
+		QSize sizeOverride,
+		const CachedIconInfo &info) {
+	auto lock = std::unique_lock(_mutex);
+	_infos[Key{ key, sizeOverride.width(), sizeOverride.height() }] = info;
+}
+
+std::optional<FrameGenerator::Frame> FramesCache::frame(
+		const QString &key,
+		int index,
+		QSize requested) {
+	auto lock = std::unique_lock(_mutex);
+	const auto i = _frames.find(Key{
+		key,
+		requested.width(),
+		requested.height(),
+		index,
+	});
+	if (i == end(_frames)) {
+		return std::nullopt;
+	}
+	_used.splice(end(_used), _used, i->second.used);
+	return i->second.frame;
+}
+
+void FramesCache::setFrame(
+		const QString &key,
+		int index,
+		QSize requested,
+		const FrameGenerator::Frame &frame) {
+	const auto bytes = int64(frame.image.sizeInBytes());
+	auto lock = std::unique_lock(_mutex);
+	if (frame.image.isNull() || bytes > _limit) {
+		return;
+	}
+	const auto full = Key{
+		key,
+		requested.width(),
+		requested.height(),
+		index,
+	};
+	const auto i = _frames.find(full);
+	if (i != end(_frames)) {
+		_bytes += bytes - int64(i->second.frame.image.sizeInBytes());
+		i->second.frame = frame;
+		_used.splice(end(_used), _used, i->second.used);
+	} else {
+		_bytes += bytes;
+		_frames.emplace(full, Entry{
+			.frame = frame,
+			.used = _used.insert(end(_used), full),
+		});
+	}
+	evict();
+}
+
+void FramesCache::evict() {
+	while (_bytes > _limit && !_used.empty()) {
+		const auto i = _frames.find(_used.front());
+		_used.pop_front();
+		if (i != end(_frames)) {
+			_bytes -= int64(i->second.frame.image.sizeInBytes());
+			_frames.erase(i);
+		}
+	}
+}
 
 } // namespace
 
@@ -30,12 +201,14 @@ struct AnimatedIcon::Frame {
 
 class AnimatedIcon::Impl final : public std::enable_shared_from_this<Impl> {
 public:
-	explicit Impl(base::weak_ptr<AnimatedIcon> weak);
+	Impl(base::weak_ptr<AnimatedIcon> weak, QString cacheKey);
 
+	void prepareFromCache(QSize sizeOverride);
 	void prepareFromAsync(
 		FnMut<std::unique_ptr<FrameGenerator>()> factory,
 		QSize sizeOverride);
 	void waitTillPrepared() const;
+	[[nodiscard]] bool prepared() const;
 
 	[[nodiscard]] bool valid() const;
 	[[nodiscard]] QSize size() const;
@@ -56,8 +229,16 @@ private:
 
 	// Called from crl::async.
 	void renderPreloadFrame();
+	[[nodiscard]] FrameGenerator::Frame renderFrame(
+		int index,
+		QImage storage);
 
 	std::unique_ptr<FrameGenerator> _generator;
+	const QString _cacheKey;
+	int _generatorIndex = -1; // Used only with _cacheKey.
+	bool _preparedFromCache = false;
+	bool _generatorWaited = false;
+	bool _valid = false;
 	Frame _current;
 	QSize _desiredSize;
 	std::atomic<PreloadState> _preloadState = PreloadState::None;
@@ -70,23 +251,61 @@ private:
 	double _frameRate = 0.;
 	mutable crl::semaphore _semaphore;
 	mutable bool _ready = false;
+	std::atomic<bool> _prepared = false; // After _semaphore is released.
+	Frame _placeholder; // Painted until the first frame is prepared.
 
 };
 
-AnimatedIcon::Impl::Impl(base::weak_ptr<AnimatedIcon> weak)
-: _weak(weak) {
+AnimatedIcon::Impl::Impl(
+	base::weak_ptr<AnimatedIcon> weak,
+	QString cacheKey)
+: _cacheKey(std::move(cacheKey))
+, _weak(weak) {
+}
+
+void AnimatedIcon::Impl::prepareFromCache(QSize sizeOverride) {
+	if (_cacheKey.isEmpty()) {
+		return;
+	}
+	const auto info = Cache().info(_cacheKey, sizeOverride);
+	if (!info) {
+		return;
+	}
+	auto first = Cache().frame(_cacheKey, 0, sizeOverride);
+	if (!first) {
+		return;
+	}
+	_framesCount = info->framesCount;
+	_frameRate = info->frameRate;
+	_desiredSize = info->desiredSize;
+	_current.generated = std::move(*first);
+
+	// The generator is still created in prepareFromAsync,
+	// but only cache misses in renderPreloadFrame will wait for it.
+	_preparedFromCache = _valid = _ready = true;
 }
 
 void AnimatedIcon::Impl::prepareFromAsync(
 		FnMut<std::unique_ptr<FrameGenerator>()> factory,
 		QSize sizeOverride) {
-	const auto guard = gsl::finally([&] { _semaphore.release(); });
+	const auto guard = gsl::finally([&] {
+		_semaphore.release();
+		_prepared = true;
+		if (!_preparedFromCache) {
+			PostToMainQueue(MainQueueLane::Paint, _weak, [=] {
+				_weak->frameJumpFinished();
+			});
+		}
+	});
 	if (!_weak) {
 		return;
 	}
 	auto generator = factory ? factory() : nullptr;
 	if (!generator || !_weak) {
 		return;
+	} else if (_preparedFromCache) {
+		_generator = std::move(generator);
+		return;
 	}
 	_framesCount = generator->count();
 	_frameRate = generator->rate();
@@ -95,9 +314,19 @@ void AnimatedIcon::Impl::prepareFromAsync(
 		return;
 	}
 	_generator = std::move(generator);
+	_generatorIndex = 0;
 	_desiredSize = sizeOverride.isEmpty()
 		? style::ConvertScale(_current.generated.image.size())
 		: sizeOverride;
+	_valid = true;
+	if (!_cacheKey.isEmpty()) {
+		Cache().setFrame(_cacheKey, 0, sizeOverride, _current.generated);
+		Cache().setInfo(_cacheKey, sizeOverride, {
+			.desiredSize = _desiredSize,
+			.framesCount = _framesCount,
+			.frameRate = _frameRate,
+		});
+	}
 }
 
 void AnimatedIcon::Impl::waitTillPrepared() const {
@@ -107,9 +336,16 @@ void AnimatedIcon::Impl::waitTillPrepared() const {
 	}
 }
 
+bool AnimatedIcon::Impl::prepared() const {
+	if (!_ready && _prepared) {
+		waitTillPrepared(); // Already released, doesn't block.
+	}
+	return _ready;
+}
+
 bool AnimatedIcon::Impl::valid() const {
 	waitTillPrepared();
-	return (_generator != nullptr);
+	return _valid;
 }
 
 QSize AnimatedIcon::Impl::size() const {
@@ -128,33 +364,33 @@ double AnimatedIcon::Impl::frameRate() const {
 }
 
 AnimatedIcon::Frame &AnimatedIcon::Impl::frame() {
-	waitTillPrepared();
-	return _current;
+	return prepared() ? _current : _placeholder;
 }
 
 const AnimatedIcon::Frame &AnimatedIcon::Impl::frame() const {
-	waitTillPrepared();
-	return _current;
+	return prepared() ? _current : _placeholder;
 }
 
 crl::time AnimatedIcon::Impl::animationDuration() const {
 	waitTillPrepared();
-	const auto rate = _generator ? _generator->rate() : 0.;
-	const auto frames = _generator ? _generator->count() : 0;
+	const auto rate = _valid ? _frameRate : 0.;
+	const auto frames = _valid ? _framesCount : 0;
 	return (frames && rate >= 1.)
 		? crl::time(base::SafeRound(frames / rate * 1000.))
 		: 0;
 }
 
 void AnimatedIcon::Impl::moveToFrame(int frame, QSize updatedDesiredSize) {
-	waitTillPrepared();
+	if (!prepared()) {
+		return;
+	}
 	const auto state = _preloadState.load();
 	const auto shown = _current.index;
 	if (!updatedDesiredSize.isEmpty()) {
 		_desiredSize = updatedDesiredSize;
 	}
 	const auto desiredImageSize = _desiredSize * style::DevicePixelRatio();
-	if (!_generator
+	if (!_valid
 		|| state == PreloadState::Preloading
 		|| (shown == frame
 			&& (_current.generated.image.size() == desiredImageSize))) {
@@ -172,6 +408,20 @@ void AnimatedIcon::Impl::moveToFrame(int frame, QSize updatedDesiredSize) {
 			std::swap(_current, _preloaded);
 		}
 	}
+	if (!_cacheKey.isEmpty()) {
+		auto cached = Cache().frame(_cacheKey, frame, desiredImageSize);
+		if (cached) {
+			_preloaded.index = frame;
+			_preloaded.generated = std::move(*cached);
+			_preloaded.resizedImage = QImage();
+			_preloadState = PreloadState::Ready;
+			std::swap(_current, _preloaded);
+			PostToMainQueue(MainQueueLane::Paint, _weak, [=] {
+				_weak->frameJumpFinished();
+			});
+			return;
+		}
+	}
 	_preloadImageSize = desiredImageSize;
 	_preloaded.index = frame;
 	_preloadState = PreloadState::Preloading;
@@ -184,26 +434,78 @@ void AnimatedIcon::Impl::renderPreloadFrame() {
 	if (!_weak) {
 		return;
 	}
-	if (_preloaded.index == 0) {
-		_generator->jumpToStart();
+	if (_preparedFromCache && !_generatorWaited) {
+		_semaphore.acquire();
+		_generatorWaited = true;
 	}
-	_preloaded.generated = (_preloaded.index && _preloaded.index == _current.index)
-		? _generator->renderCurrent(
-			std::move(_preloaded.generated.image),
-			_preloadImageSize)
-		: _generator->renderNext(
-			std::move(_preloaded.generated.image),
+	auto rendered = renderFrame(
+		_preloaded.index,
+		std::move(_preloaded.generated.image));
+	if (rendered.image.isNull() && !_cacheKey.isEmpty()) {
+		// The generator failed after the icon was prepared from the cache,
+		// try the cache again or keep showing the current frame.
+		auto cached = Cache().frame(
+			_cacheKey,
+			_preloaded.index,
 			_preloadImageSize);
+		rendered = cached ? std::move(*cached) : _current.generated;
+	}
+	_preloaded.generated = std::move(rendered);
 	_preloaded.resizedImage = QImage();
 	_preloadState = PreloadState::Ready;
-	crl::on_main(_weak, [=] {
+	PostToMainQueue(MainQueueLane::Paint, _weak, [=] {
 		_weak->frameJumpFinished();
 	});
 }
 
+FrameGenerator::Frame AnimatedIcon::Impl::renderFrame(
+		int index,
+		QImage storage) {
+	if (!_generator) {
+		return {};
+	} else if (_cacheKey.isEmpty()) {
+		if (index == 0) {
+			_generator->jumpToStart();
+		}
+		return (index && index == _current.index)
+			? _generator->renderCurrent(std::move(storage), _preloadImageSize)
+			: _generator->renderNext(std::move(storage), _preloadImageSize);
+	}
+
+	// Cache hits don't advance the generator, so it may need to catch up.
+	// Shared frames can't be used as a storage for the next one.
+	if (!storage.isDetached()) {
+		storage = QImage();
+	}
+	const auto remember = [&](int at, FrameGenerator::Frame frame) {
+		Cache().setFrame(_cacheKey, at, _preloadImageSize, frame);
+		return frame;
+	};
+	if (index > 0 && index == _generatorIndex) {
+		return remember(index, _generator->renderCurrent(
+			std::move(storage),
+			_preloadImageSize));
+	} else if (index == 0 || index < _generatorIndex) {
+		_generator->jumpToStart();
+		_generatorIndex = -1;
+	}
+	while (_generatorIndex + 1 < index) {
+		remember(
+			++_generatorIndex,
+			_generator->renderNext(QImage(), _preloadImageSize));
+	}
+	_generatorIndex = index;
+	return remember(index, _generator->renderNext(
+		std::move(storage),
+		_preloadImageSize));
+}
+
 AnimatedIcon::AnimatedIcon(AnimatedIconDescriptor &&descriptor)
-: _impl(std::make_shared<Impl>(base::make_weak(this)))
+: _impl(std::make_shared<Impl>(
+	base::make_weak(this),
+	ComputeCacheKey(descriptor)))
 , _colorized(descriptor.colorized) {
+	_impl->prepareFromCache(descriptor.sizeOverride);
 	crl::async([
 		impl = _impl,
 		factory = std::move(descriptor.generator),
@@ -260,10 +562,14 @@ AnimatedIcon::ResizedFrame AnimatedIcon::notColorizedFrame(
 		Fn<void()> updateWithPerfect) const {
 	auto &frame = _impl->frame();
 	preloadNextFrame(crl::now(), &frame, desiredSize);
-	const auto desired = size() * style::DevicePixelRatio();
 	if (frame.generated.image.isNull()) {
+		if (updateWithPerfect && !_impl->prepared()) {
+			_repaint = std::move(updateWithPerfect);
+		}
 		return { frame.generated.image };
-	} else if (frame.generated.image.size() == desired) {
+	}
+	const auto desired = size() * style::DevicePixelRatio();
+	if (frame.generated.image.size() == desired) {
 		return { frame.generated.image };
 	} else if (frame.resizedImage.size() != desired) {
 		frame.resizedImage = frame.generated.image.scaled(
@@ -300,6 +606,9 @@ void AnimatedIcon::paint(QPainter &p, int x, int y) {
 }
 
 void AnimatedIcon::paintInCenter(QPainter &p, QRect rect) {
+	if (!_impl->prepared()) {
+		return;
+	}
 	const auto my = size();
 	paint(
 		p,
@@ -426,4 +735,8 @@ std::unique_ptr<AnimatedIcon> MakeAnimatedIcon(
 	return std::make_unique<AnimatedIcon>(std::move(descriptor));
 }
 
+void SetAnimatedIconCacheLimit(int64 bytes) {
+	Cache().setLimit(bytes);
+}
+
 } // namespace Lottie
@@ -22,6 +22,12 @@ struct AnimatedIconDescriptor {
 	FnMut<std::unique_ptr<FrameGenerator>()> generator;
 	QSize sizeOverride;
 	bool colorized = false;
+
+	// Icons with the same non-empty key share decoded frames.
+	QString cacheKey;
+
+	// The data the generator decodes, gives a default cacheKey.
+	QByteArray source;
 };
 
 class AnimatedIcon final : public base::has_weak_ptr {
@@ -99,4 +105,7 @@ private:
 [[nodiscard]] std::unique_ptr<AnimatedIcon> MakeAnimatedIcon(
 	AnimatedIconDescriptor &&descriptor);
 
+// Budget for frames shared by AnimatedIcon-s with a cacheKey.
+void SetAnimatedIconCacheLimit(int64 bytes);
+
 } // namespace Ui
@@ -7,7 +7,9 @@
 #include "ui/effects/animations.h"
 
 #include "base/invoke_queued.h"
+#include "ui/effects/frame_clock.h"
 #include "ui/ui_utility.h"
+#include "ui/ui_trace.h"
 #include "styles/style_basic.h"
 
 #include <QtCore/QPointer>
@@ -52,7 +54,7 @@ void Basic::stop() {
 void Basic::restart() {
 	Expects(_started >= 0);
 
-	_started = crl::now();
+	_started = ManagerInstance->now();
 
 	Ensures(_started >= 0);
 }
@@ -60,7 +62,7 @@ void Basic::restart() {
 void Basic::markStarted() {
 	Expects(_started < 0);
 
-	_started = crl::now();
+	_started = ManagerInstance->now();
 
 	Ensures(_started >= 0);
 }
@@ -78,7 +80,7 @@ Manager::Manager() {
 
 	crl::on_main_update_requests(
 	) | rpl::filter([=] {
-		return (_lastUpdateTime + kIgnoreUpdatesTimeout < crl::now());
+		return (_lastUpdateTime + kIgnoreUpdatesTimeout < now());
 	}) | rpl::on_next([=] {
 		update();
 	}, _lifetime);
@@ -92,6 +94,42 @@ Manager::~Manager() {
 	ManagerInstance = nullptr;
 }
 
+crl::time Manager::now() const {
+	return _clock ? _clock->now() : crl::now();
+}
+
+void Manager::setFrameClock(std::unique_ptr<FrameClock> clock) {
+	stopTimer();
+	_clock = std::move(clock);
+	if (_clock) {
+		_clock->setTickCallback([=] { update(); });
+	}
+	if (!_active.empty()) {
+		_forceImmediateUpdate = true;
+		schedule();
+	}
+}
+
+FrameClock *Manager::frameClock() const {
+	return _clock.get();
+}
+
+void PaceByWindow(not_null<QWindow*> window) {
+	if (!ManagerInstance) {
+		return;
+	}
+	const auto clock = ManagerInstance->frameClock();
+	const auto paced = dynamic_cast<WindowFrameClock*>(clock);
+	if (clock && !paced) {
+		// Some other clock is set on purpose, like in tests.
+		return;
+	} else if (paced && paced->window() == window) {
+		return;
+	}
+	ManagerInstance->setFrameClock(
+		std::make_unique<WindowFrameClock>(window));
+}
+
 void Manager::start(not_null<Basic*> animation) {
 	_forceImmediateUpdate = true;
 	if (_updating) {
@@ -126,16 +164,17 @@ void Manager::update() {
 	if (_active.empty() || _updating || _scheduled) {
 		return;
 	}
-	const auto now = crl::now();
+	const auto now = this->now();
 	if (_forceImmediateUpdate) {
 		_forceImmediateUpdate = false;
 	}
+	_lastUpdateTime = now;
 	schedule();
 
+	UI_TRACE_SCOPE("Animations::update");
 	_updating = true;
 	const auto guard = gsl::finally([&] { _updating = false; });
 
-	_lastUpdateTime = now;
 	const auto isFinished = [&](const ActiveBasicPointer &element) {
 		return !element.call(now);
 	};
@@ -154,6 +193,9 @@ void Manager::update() {
 			std::make_move_iterator(end(_starting)));
 		_starting.clear();
 	}
+	if (_clock && _active.empty()) {
+		_clock->cancel();
+	}
 }
 
 void Manager::updateQueued() {
@@ -169,7 +211,14 @@ void Manager::updateQueued() {
 }
 
 void Manager::schedule() {
-	if (_scheduled || _timerId < 0) {
+	if (_clock) {
+		// The clock decides when to tick by itself, so that a manual
+		// clock ticks right from advance() without an event loop turn.
+		_clock->request(base::take(_forceImmediateUpdate)
+			? now()
+			: (_lastUpdateTime + kAnimationTick));
+		return;
+	} else if (_scheduled || _timerId < 0) {
 		return;
 	}
 	stopTimer();
@@ -177,7 +226,7 @@ void Manager::schedule() {
 	_scheduled = true;
 	const auto callback = [=] {
 		_scheduled = false;
-		if (_active.empty()) {
+		if (_active.empty() || _clock) {
 			return;
 		}
 		if (_forceImmediateUpdate) {
@@ -205,6 +254,9 @@ not_null<const QObject*> Manager::delayedCallGuard() const {
 }
 
 void Manager::stopTimer() {
+	if (_clock) {
+		_clock->cancel();
+	}
 	if (_timerId > 0) {
 		killTimer(base::take(_timerId));
 	}
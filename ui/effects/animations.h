@@ -12,10 +12,13 @@
 #include <rpl/lifetime.h>
 #include <QtCore/QObject>
 
+class QWindow;
+
 namespace Ui {
 namespace Animations {
 
 class Manager;
+class FrameClock;
 
 class Basic final {
 public:
@@ -140,6 +143,11 @@ public:
 	~Manager();
 
 	void update();
+	[[nodiscard]] crl::time now() const;
+
+	// Replaces the default timer scheduling, nullptr restores it.
+	void setFrameClock(std::unique_ptr<FrameClock> clock);
+	[[nodiscard]] FrameClock *frameClock() const;
 
 	static void SetScheduleWithInvokeQueued(bool value);
 
@@ -201,6 +209,7 @@ private:
 	not_null<const QObject*> delayedCallGuard() const;
 
 	crl::time _lastUpdateTime = 0;
+	std::unique_ptr<FrameClock> _clock;
 	int _timerId = 0;
 	bool _updating = false;
 	bool _removedWhileUpdating = false;
@@ -212,6 +221,10 @@ private:
 
 };
 
+// Ticks the animations in phase with the window presentation, switching
+// from the previous window, unless a different frame clock was set.
+void PaceByWindow(not_null<QWindow*> window);
+
 template <typename Callback>
 Fn<bool(crl::time)> Basic__PrepareCrlTime(Callback &&callback) {
 	using Return = decltype(callback(crl::time(0)));
@@ -0,0 +1,144 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "ui/effects/frame_clock.h"
+
+#include <QtCore/QEvent>
+#include <QtGui/QWindow>
+
+namespace Ui::Animations {
+namespace {
+
+constexpr auto kPresentationFallbackDelay = crl::time(50);
+constexpr auto kHiddenTickDelay = crl::time(500);
+
+} // namespace
+
+crl::time FrameClock::now() const {
+	return crl::now();
+}
+
+void FrameClock::setTickCallback(Fn<void()> callback) {
+	_tick = std::move(callback);
+}
+
+void FrameClock::tick() {
+	if (const auto onstack = _tick) {
+		onstack();
+	}
+}
+
+TimerFrameClock::TimerFrameClock() : _timer([=] { tick(); }) {
+}
+
+void TimerFrameClock::request(crl::time when) {
+	_timer.callOnce(std::max(when - now(), crl::time(0)));
+}
+
+void TimerFrameClock::cancel() {
+	_timer.cancel();
+}
+
+WindowFrameClock::WindowFrameClock(not_null<QWindow*> window)
+: _window(window.get())
+, _fallback([=] {
+	if (base::take(_requested)) {
+		tick();
+	}
+}) {
+	window->installEventFilter(this);
+}
+
+WindowFrameClock::~WindowFrameClock() {
+	if (_window) {
+		_window->removeEventFilter(this);
+	}
+}
+
+QWindow *WindowFrameClock::window() const {
+	return _window.data();
+}
+
+void WindowFrameClock::request(crl::time when) {
+	_when = when;
+	_requested = true;
+	schedule();
+}
+
+void WindowFrameClock::cancel() {
+	_requested = false;
+	_fallback.cancel();
+}
+
+void WindowFrameClock::schedule() {
+	const auto delay = std::max(_when - now(), crl::time(0));
+	if (!_window) {
+		_fallback.callOnce(delay);
+	} else if (_window->isExposed()) {
+		_window->requestUpdate();
+
+		// In case the window is unexposed before it gets UpdateRequest.
+		_fallback.callOnce(delay + kPresentationFallbackDelay);
+	} else {
+		// Nothing is visible, skip the ticks until the window is exposed.
+		_fallback.callOnce(std::max(delay, kHiddenTickDelay));
+	}
+}
+
+bool WindowFrameClock::eventFilter(QObject *o, QEvent *e) {
+	if (o != _window) {
+		return false;
+	} else if (e->type() == QEvent::UpdateRequest) {
+		if (base::take(_requested)) {
+			_fallback.cancel();
+			tick();
+		}
+	} else if (e->type() == QEvent::Expose
+		&& _requested
+		&& _window->isExposed()) {
+		schedule();
+	}
+	return false;
+}
+
+ManualFrameClock::ManualFrameClock(crl::time now) : _now(now) {
+}
+
+crl::time ManualFrameClock::now() const {
+	return _now;
+}
+
+void ManualFrameClock::request(crl::time when) {
+	_when = std::max(when, crl::time(0));
+}
+
+void ManualFrameClock::cancel() {
+	_when = -1;
+}
+
+void ManualFrameClock::setNow(crl::time now) {
+	Expects(now >= _now);
+
+	_now = now;
+	tickIfDue();
+}
+
+void ManualFrameClock::advance(crl::time delta) {
+	setNow(_now + delta);
+}
+
+bool ManualFrameClock::requested() const {
+	return (_when >= 0);
+}
+
+void ManualFrameClock::tickIfDue() {
+	if (_when >= 0 && _when <= _now) {
+		_when = -1;
+		tick();
+	}
+}
+
+} // namespace Ui::Animations
@@ -0,0 +1,101 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+#include "base/timer.h"
+
+#include <crl/crl_time.h>
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+
+class QWindow;
+
+namespace Ui::Animations {
+
+// Drives Animations::Manager ticks. The manager asks for a single tick
+// not earlier than 'when' and the clock decides when exactly to deliver
+// it, for example in phase with the window presentation.
+class FrameClock {
+public:
+	virtual ~FrameClock() = default;
+
+	[[nodiscard]] virtual crl::time now() const;
+
+	// A new request replaces the previous one.
+	virtual void request(crl::time when) = 0;
+	virtual void cancel() = 0;
+
+	void setTickCallback(Fn<void()> callback);
+
+protected:
+	void tick();
+
+private:
+	Fn<void()> _tick;
+
+};
+
+class TimerFrameClock final : public FrameClock {
+public:
+	TimerFrameClock();
+
+	void request(crl::time when) override;
+	void cancel() override;
+
+private:
+	base::Timer _timer;
+
+};
+
+// Ticks right before the window handles QEvent::UpdateRequest, so that
+// animation callbacks run once per presented frame at the display rate.
+// While the window is not exposed the ticks are skipped, only a rare
+// timer tick is left so that the animations still finish.
+class WindowFrameClock final : public FrameClock, private QObject {
+public:
+	explicit WindowFrameClock(not_null<QWindow*> window);
+	~WindowFrameClock();
+
+	[[nodiscard]] QWindow *window() const;
+
+	void request(crl::time when) override;
+	void cancel() override;
+
+private:
+	bool eventFilter(QObject *o, QEvent *e) override;
+	void schedule();
+
+	QPointer<QWindow> _window;
+	base::Timer _fallback;
+	crl::time _when = 0;
+	bool _requested = false;
+
+};
+
+// Deterministic clock for headless tests and benchmarks:
+// the time moves only through setNow() / advance().
+class ManualFrameClock final : public FrameClock {
+public:
+	explicit ManualFrameClock(crl::time now = 0);
+
+	[[nodiscard]] crl::time now() const override;
+	void request(crl::time when) override;
+	void cancel() override;
+
+	void setNow(crl::time now);
+	void advance(crl::time delta);
+	[[nodiscard]] bool requested() const;
+
+private:
+	void tickIfDue();
+
+	crl::time _now = 0;
+	crl::time _when = -1;
+
+};
+
+} // namespace Ui::Animations
@@ -6,6 +6,7 @@
 //
 #include "ui/effects/frame_generator.h"
 
+#include "ui/image/image_pool.h"
 #include "ui/image/image_prepare.h"
 
 namespace Ui {
@@ -54,7 +55,9 @@ FrameGenerator::Frame ImageFrameGenerator::renderCurrent(
 	if (scaled.size() == size) {
 		return { .image = std::move(scaled) };
 	}
-	auto result = QImage(size, QImage::Format_ARGB32_Premultiplied);
+	auto result = GoodStorageForFrame(storage, size)
+		? std::move(storage)
+		: CreateFrameStorage(size);
 	result.fill(Qt::transparent);
 
 	const auto skipx = (size.width() - scaled.width()) / 2;
@@ -63,7 +66,7 @@ FrameGenerator::Frame ImageFrameGenerator::renderCurrent(
 	const auto dstPerLine = result.bytesPerLine();
 	const auto lineBytes = scaled.width() * 4;
 	auto src = scaled.constBits();
-	auto dst = result.bits() + (skipx * 4) + (skipy * srcPerLine);
+	auto dst = result.bits() + (skipx * 4) + (skipy * dstPerLine);
 	for (auto y = 0, height = scaled.height(); y != height; ++y) {
 		memcpy(dst, src, lineBytes);
 		src += srcPerLine;
@@ -76,4 +79,15 @@ FrameGenerator::Frame ImageFrameGenerator::renderCurrent(
 void ImageFrameGenerator::jumpToStart() {
 }
 
+bool GoodStorageForFrame(const QImage &storage, QSize size) {
+	return !storage.isNull()
+		&& (storage.format() == QImage::Format_ARGB32_Premultiplied)
+		&& (storage.size() == size)
+		&& storage.isDetached();
+}
+
+QImage CreateFrameStorage(QSize size) {
+	return Images::PooledImage(size);
+}
+
 } // namespace Ui
@@ -7,6 +7,7 @@
 #include "ui/effects/panel_animation.h"
 
 #include "ui/effects/animation_value.h"
+#include "ui/image/image_pool.h"
 #include "ui/ui_utility.h"
 
 #include <QtGui/QPainter>
@@ -18,8 +19,9 @@ void RoundShadowAnimation::start(int frameWidth, int frameHeight, float64 device
 
 	_frameWidth = frameWidth;
 	_frameHeight = frameHeight;
-	_frame = QImage(_frameWidth, _frameHeight, QImage::Format_ARGB32_Premultiplied);
-	_frame.setDevicePixelRatio(devicePixelRatio);
+	_frame = Images::PooledImage(
+		QSize(_frameWidth, _frameHeight),
+		devicePixelRatio);
 	_frameIntsPerLine = (_frame.bytesPerLine() >> 2);
 	_frameInts = reinterpret_cast<uint32*>(_frame.bits());
 	_frameIntsPerLineAdded = _frameIntsPerLine - _frameWidth;
@@ -9,10 +9,173 @@
 #include "ui/effects/animations.h"
 #include "ui/painter.h"
 #include "ui/ui_utility.h"
+#include "ui/image/image_pool.h"
 #include "ui/image/image_prepare.h"
 #include "styles/style_widgets.h"
 
 namespace Ui {
+namespace {
+
+constexpr auto kMaxUnusedMasks = 32;
+
+enum class MaskShape : uchar {
+	Rect,
+	RoundRect,
+	Corners,
+	Ellipse,
+};
+
+struct MaskKey {
+	MaskShape shape = MaskShape::Rect;
+	int width = 0;
+	int height = 0;
+	int radius = 0;
+	std::array<qint64, 4> corners = {};
+
+	friend inline std::strong_ordering operator<=>(
+		const MaskKey &a,
+		const MaskKey &b) = default;
+	friend inline bool operator==(
+		const MaskKey &a,
+		const MaskKey &b) = default;
+};
+
+// Identical buttons share ripple masks, they are implicitly shared images.
+struct MaskCache {
+	base::flat_map<MaskKey, QImage> masks;
+	int scale = 0;
+	int ratio = 0;
+};
+
+MaskCache Masks;
+
+template <typename Generator>
+[[nodiscard]] QImage CachedMask(MaskKey key, Generator &&generate) {
+	const auto scale = style::Scale();
+	const auto ratio = style::DevicePixelRatio();
+	if (Masks.scale != scale || Masks.ratio != ratio) {
+		Masks.masks.clear();
+		Masks.scale = scale;
+		Masks.ratio = ratio;
+	}
+	if (const auto i = Masks.masks.find(key); i != end(Masks.masks)) {
+		return i->second;
+	}
+	const auto unused = [](const auto &pair) {
+		return pair.second.isDetached();
+	};
+	if (ranges::count_if(Masks.masks, unused) >= kMaxUnusedMasks) {
+		for (auto i = begin(Masks.masks); i != end(Masks.masks);) {
+			if (unused(*i)) {
+				i = Masks.masks.erase(i);
+			} else {
+				++i;
+			}
+		}
+	}
+	auto result = generate();
+	Masks.masks.emplace(key, result);
+	return result;
+}
+
+[[nodiscard]] inline uint32 MultiplyPremultiplied(
+		uint32 argb,
+		uint32 alpha) {
+	auto rb = (argb & 0x00FF00FFU) * alpha;
+	rb = ((rb + ((rb >> 8) & 0x00FF00FFU) + 0x00800080U) >> 8)
+		& 0x00FF00FFU;
+	auto ag = ((argb >> 8) & 0x00FF00FFU) * alpha;
+	ag = (ag + ((ag >> 8) & 0x00FF00FFU) + 0x00800080U) & 0xFF00FF00U;
+	return rb | ag;
+}
+
+// Coverage of a pixel by the antialiased circle edge, sampled by the
+// squared distance from the center, so that pixels need no square root.
+class RadialCoverage final {
+public:
+	explicit RadialCoverage(float64 radius) {
+		const auto inner = std::max(radius - 0.5, 0.);
+		const auto outer = radius + 0.5;
+		_inner2 = inner * inner;
+		_outer2 = outer * outer;
+		_scale = kSteps / (_outer2 - _inner2);
+		for (auto i = 0; i != kSteps + 1; ++i) {
+			const auto distance = std::sqrt(_inner2 + i / _scale);
+			const auto coverage = (outer - distance) * 256.;
+			_table[i] = uint32(std::clamp(coverage, 0., 256.));
+		}
+	}
+
+	[[nodiscard]] float64 inner2() const {
+		return _inner2;
+	}
+	[[nodiscard]] float64 outer2() const {
+		return _outer2;
+	}
+	[[nodiscard]] uint32 operator()(float64 distance2) const {
+		return (distance2 <= _inner2)
+			? 256U
+			: (distance2 >= _outer2)
+			? 0U
+			: _table[int((distance2 - _inner2) * _scale)];
+	}
+
+private:
+	static constexpr auto kSteps = 256;
+
+	float64 _inner2 = 0.;
+	float64 _outer2 = 0.;
+	float64 _scale = 0.;
+	std::array<uint32, kSteps + 1> _table = {};
+
+};
+
+// Writes every pixel of 'region' (in device pixels) in one pass:
+// antialiased circle coverage, multiplied by the mask alpha and the color.
+void FillRippleCircle(
+		QImage &frame,
+		const QImage &mask,
+		QRect region,
+		QPointF center,
+		float64 radius,
+		const QColor &color) {
+	const auto argb = qPremultiply(color.rgba());
+	const auto coverage = RadialCoverage(radius);
+	const auto inner2 = coverage.inner2();
+	const auto outer2 = coverage.outer2();
+	const auto left = region.x();
+	const auto till = region.x() + region.width();
+	for (auto y = region.y(); y != region.y() + region.height(); ++y) {
+		const auto dy = y + 0.5 - center.y();
+		const auto dy2 = dy * dy;
+		const auto to = reinterpret_cast<uint32*>(frame.scanLine(y));
+		if (dy2 >= outer2) {
+			std::fill(to + left, to + till, 0U);
+			continue;
+		}
+		const auto from = reinterpret_cast<const uint32*>(
+			mask.constScanLine(y));
+
+		// Pixels closer than innerHalf are fully covered in this row,
+		// only the edge between it and outerHalf needs the lookup.
+		const auto outerHalf = std::sqrt(outer2 - dy2);
+		const auto innerHalf = (dy2 < inner2)
+			? std::sqrt(inner2 - dy2)
+			: 0.;
+		for (auto x = left; x != till; ++x) {
+			const auto dx = std::abs(x + 0.5 - center.x());
+			const auto covered = (dx < innerHalf)
+				? 256U
+				: (dx >= outerHalf)
+				? 0U
+				: coverage(dx * dx + dy2);
+			const auto alpha = ((from[x] >> 24) * covered) >> 8;
+			to[x] = alpha ? MultiplyPremultiplied(argb, alpha) : 0U;
+		}
+	}
+}
+
+} // namespace
 
 class RippleAnimation::Ripple {
 public:
@@ -20,16 +183,17 @@ public:
 		const style::RippleAnimation &st,
 		QPoint origin,
 		int startRadius,
-		const QPixmap &mask,
+		const QImage &mask,
 		Fn<void()> update);
 	Ripple(
 		const style::RippleAnimation &st,
-		const QPixmap &mask,
+		const QImage &mask,
 		Fn<void()> update);
 
 	void paint(
 		QPainter &p,
-		const QPixmap &mask,
+		const QImage &mask,
+		QImage &frame,
 		const QColor *colorOverride);
 
 	void stop();
@@ -52,7 +216,7 @@ private:
 	Ui::Animations::Simple _show;
 	Ui::Animations::Simple _hide;
 	QPixmap _cache;
-	QImage _frame;
+	QPoint _cacheTopLeft;
 
 };
 
@@ -60,21 +224,18 @@ RippleAnimation::Ripple::Ripple(
 	const style::RippleAnimation &st,
 	QPoint origin,
 	int startRadius,
-	const QPixmap &mask,
+	const QImage &mask,
 	Fn<void()> update)
 : _st(st)
 , _update(std::move(update))
 , _origin(origin)
-, _radiusFrom(startRadius)
-, _frame(mask.size(), QImage::Format_ARGB32_Premultiplied) {
-	_frame.setDevicePixelRatio(mask.devicePixelRatio());
-
+, _radiusFrom(startRadius) {
 	const auto pixelRatio = style::DevicePixelRatio();
 	QPoint points[] = {
 		{ 0, 0 },
-		{ _frame.width() / pixelRatio, 0 },
-		{ _frame.width() / pixelRatio, _frame.height() / pixelRatio },
-		{ 0, _frame.height() / pixelRatio },
+		{ mask.width() / pixelRatio, 0 },
+		{ mask.width() / pixelRatio, mask.height() / pixelRatio },
+		{ 0, mask.height() / pixelRatio },
 	};
 	for (auto point : points) {
 		accumulate_max(
@@ -86,28 +247,29 @@ RippleAnimation::Ripple::Ripple(
 	_show.start(_update, 0., 1., _st.showDuration, anim::easeOutQuint);
 }
 
-RippleAnimation::Ripple::Ripple(const style::RippleAnimation &st, const QPixmap &mask, Fn<void()> update)
+RippleAnimation::Ripple::Ripple(const style::RippleAnimation &st, const QImage &mask, Fn<void()> update)
 : _st(st)
 , _update(std::move(update))
 , _origin(
 	mask.width() / (2 * style::DevicePixelRatio()),
 	mask.height() / (2 * style::DevicePixelRatio()))
-, _radiusFrom(mask.width() + mask.height())
-, _frame(mask.size(), QImage::Format_ARGB32_Premultiplied) {
-	_frame.setDevicePixelRatio(mask.devicePixelRatio());
+, _radiusFrom(mask.width() + mask.height()) {
 	_radiusTo = _radiusFrom;
 	_hide.start(_update, 0., 1., _st.hideDuration);
 }
 
 void RippleAnimation::Ripple::paint(
 		QPainter &p,
-		const QPixmap &mask,
+		const QImage &mask,
+		QImage &frame,
 		const QColor *colorOverride) {
 	auto opacity = _hide.value(_hiding ? 0. : 1.);
 	if (opacity == 0.) {
 		return;
 	}
 
+	auto saved = p.opacity();
+	if (opacity != 1.) p.setOpacity(saved * opacity);
 	if (_cache.isNull() || colorOverride != nullptr) {
 		const auto shown = _show.value(1.);
 		Assert(!std::isnan(shown));
@@ -120,32 +282,34 @@ void RippleAnimation::Ripple::paint(
 		Assert(!std::isnan(interpolated));
 		auto radius = int(base::SafeRound(interpolated));
 		//anim::interpolate(_radiusFrom, _radiusTo, _show.value(1.));
-		_frame.fill(Qt::transparent);
-		{
-			QPainter p(&_frame);
-			p.setPen(Qt::NoPen);
-			if (colorOverride) {
-				p.setBrush(*colorOverride);
+
+		// Touch only the part of the frame the circle can cover.
+		const auto ratio = style::DevicePixelRatio();
+		const auto bounds = QRect(
+			_origin - QPoint(radius + 1, radius + 1),
+			QSize(2 * radius + 2, 2 * radius + 2)
+		).intersected(QRect(QPoint(), mask.size() / ratio));
+		if (!bounds.isEmpty()) {
+			const auto region = QRect(
+				bounds.topLeft() * ratio,
+				bounds.size() * ratio);
+			FillRippleCircle(
+				frame,
+				mask,
+				region,
+				QPointF(_origin * ratio),
+				float64(radius * ratio),
+				colorOverride ? *colorOverride : _st.color->c);
+			if (radius == _radiusTo && colorOverride == nullptr) {
+				_cache = PixmapFromImage(frame.copy(region));
+				_cacheTopLeft = bounds.topLeft();
 			} else {
-				p.setBrush(_st.color);
-			}
-			{
-				PainterHighQualityEnabler hq(p);
-				p.drawEllipse(_origin, radius, radius);
+				p.drawImage(bounds, frame, region);
 			}
-			p.setCompositionMode(QPainter::CompositionMode_DestinationIn);
-			p.drawPixmap(0, 0, mask);
-		}
-		if (radius == _radiusTo && colorOverride == nullptr) {
-			_cache = PixmapFromImage(std::move(_frame));
 		}
 	}
-	auto saved = p.opacity();
-	if (opacity != 1.) p.setOpacity(saved * opacity);
-	if (_cache.isNull()) {
-		p.drawImage(0, 0, _frame);
-	} else {
-		p.drawPixmap(0, 0, _cache);
+	if (!_cache.isNull() && colorOverride == nullptr) {
+		p.drawPixmap(_cacheTopLeft, _cache);
 	}
 	if (opacity != 1.) p.setOpacity(saved);
 }
@@ -181,8 +345,12 @@ RippleAnimation::RippleAnimation(
 	QImage mask,
 	Fn<void()> callback)
 : _st(st)
-, _mask(PixmapFromImage(std::move(mask)))
+, _mask(std::move(mask))
 , _update(std::move(callback)) {
+	if (_mask.format() != QImage::Format_ARGB32_Premultiplied) {
+		_mask = std::move(_mask).convertToFormat(
+			QImage::Format_ARGB32_Premultiplied);
+	}
 }
 
 
@@ -237,9 +405,14 @@ void RippleAnimation::paint(
 	if (style::RightToLeft()) {
 		x = outerWidth - x - (_mask.width() / style::DevicePixelRatio());
 	}
+	if (_frame.size() != _mask.size()) {
+		_frame = Images::PooledImage(
+			_mask.size(),
+			_mask.devicePixelRatio());
+	}
 	p.translate(x, y);
 	for (const auto &ripple : _ripples) {
-		ripple->paint(p, _mask, colorOverride);
+		ripple->paint(p, _mask, _frame, colorOverride);
 	}
 	p.translate(-x, -y);
 	clearFinished();
@@ -266,46 +439,86 @@ QImage RippleAnimation::MaskByDrawer(
 }
 
 QImage RippleAnimation::RectMask(QSize size) {
-	return MaskByDrawer(size, true, nullptr);
+	const auto key = MaskKey{
+		.shape = MaskShape::Rect,
+		.width = size.width(),
+		.height = size.height(),
+	};
+	return CachedMask(key, [&] {
+		return MaskByDrawer(size, true, nullptr);
+	});
 }
 
 QImage RippleAnimation::RoundRectMask(QSize size, int radius) {
-	return MaskByDrawer(size, false, [&](QPainter &p) {
-		p.drawRoundedRect(0, 0, size.width(), size.height(), radius, radius);
+	const auto key = MaskKey{
+		.shape = MaskShape::RoundRect,
+		.width = size.width(),
+		.height = size.height(),
+		.radius = radius,
+	};
+	return CachedMask(key, [&] {
+		return MaskByDrawer(size, false, [&](QPainter &p) {
+			p.drawRoundedRect(
+				0,
+				0,
+				size.width(),
+				size.height(),
+				radius,
+				radius);
+		});
 	});
 }
 
 QImage RippleAnimation::RoundRectMask(
 		QSize size,
 		Images::CornersMaskRef corners) {
-	return MaskByDrawer(size, true, [&](QPainter &p) {
-		p.setCompositionMode(QPainter::CompositionMode_Source);
-		const auto ratio = style::DevicePixelRatio();
-		const auto corner = [&](int index, bool right, bool bottom) {
-			if (const auto image = corners.p[index]) {
-				if (!image->isNull()) {
-					const auto width = image->width() / ratio;
-					const auto height = image->height() / ratio;
-					p.drawImage(
-						QRect(
-							right ? (size.width() - width) : 0,
-							bottom ? (size.height() - height) : 0,
-							width,
-							height),
-						*image);
+	auto key = MaskKey{
+		.shape = MaskShape::Corners,
+		.width = size.width(),
+		.height = size.height(),
+	};
+	for (auto i = 0; i != 4; ++i) {
+		if (const auto image = corners.p[i]; image && !image->isNull()) {
+			key.corners[i] = image->cacheKey();
+		}
+	}
+	return CachedMask(key, [&] {
+		return MaskByDrawer(size, true, [&](QPainter &p) {
+			p.setCompositionMode(QPainter::CompositionMode_Source);
+			const auto ratio = style::DevicePixelRatio();
+			const auto corner = [&](int index, bool right, bool bottom) {
+				if (const auto image = corners.p[index]) {
+					if (!image->isNull()) {
+						const auto width = image->width() / ratio;
+						const auto height = image->height() / ratio;
+						p.drawImage(
+							QRect(
+								right ? (size.width() - width) : 0,
+								bottom ? (size.height() - height) : 0,
+								width,
+								height),
+							*image);
+					}
 				}
-			}
-		};
-		corner(0, false, false);
-		corner(1, true, false);
-		corner(2, false, true);
-		corner(3, true, true);
+			};
+			corner(0, false, false);
+			corner(1, true, false);
+			corner(2, false, true);
+			corner(3, true, true);
+		});
 	});
 }
 
 QImage RippleAnimation::EllipseMask(QSize size) {
-	return MaskByDrawer(size, false, [&](QPainter &p) {
-		p.drawEllipse(0, 0, size.width(), size.height());
+	const auto key = MaskKey{
+		.shape = MaskShape::Ellipse,
+		.width = size.width(),
+		.height = size.height(),
+	};
+	return CachedMask(key, [&] {
+		return MaskByDrawer(size, false, [&](QPainter &p) {
+			p.drawEllipse(0, 0, size.width(), size.height());
+		});
 	});
 }
 
@@ -313,6 +526,9 @@ void RippleAnimation::clearFinished() {
 	while (!_ripples.empty() && _ripples.front()->finished()) {
 		_ripples.pop_front();
 	}
+	if (_ripples.empty()) {
+		_frame = QImage();
+	}
 }
 
 void RippleAnimation::clear() {
@@ -61,7 +61,8 @@ private:
 	void clearFinished();
 
 	const style::RippleAnimation &_st;
-	QPixmap _mask;
+	QImage _mask;
+	QImage _frame; // Shared by all the ripples, they paint one by one.
 	Fn<void()> _update;
 
 	class Ripple;
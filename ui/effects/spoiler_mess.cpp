@@ -21,6 +21,7 @@
 #include <xxhash.h>
 #include <mutex>
 #include <condition_variable>
+#include <thread>
 
 namespace Ui {
 namespace {
@@ -121,9 +122,35 @@ struct Particle {
 	float64 dy = 0.;
 };
 
+// Deterministic source for GenerateSpoilerMess with a fixed seed.
+class SeededRandom final {
+public:
+	explicit SeededRandom(uint64 seed) : _state(seed) {
+	}
+
+	[[nodiscard]] uint32 next() {
+		// splitmix64, good enough and stable across platforms.
+		auto z = (_state += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return uint32((z ^ (z >> 31)) >> 32);
+	}
+
+private:
+	uint64 _state = 0;
+
+};
+
+[[nodiscard]] int RandomIndex(int count, SeededRandom &random) {
+	Expects(count > 0);
+
+	return int((uint64(random.next()) * uint64(count)) >> 32);
+}
+
+template <typename Random>
 [[nodiscard]] std::pair<float64, float64> RandomSpeed(
 		const SpoilerMessDescriptor &descriptor,
-		base::BufferedRandom<uint32> &random) {
+		Random &random) {
 	const auto count = descriptor.particlesCount;
 	const auto speedMax = descriptor.particleSpeedMax;
 	const auto speedMin = descriptor.particleSpeedMin;
@@ -145,10 +172,11 @@ struct Particle {
 	return { k * x, k * y };
 }
 
+template <typename Random>
 [[nodiscard]] Particle GenerateParticle(
 		const SpoilerMessDescriptor &descriptor,
 		int index,
-		base::BufferedRandom<uint32> &random) {
+		Random &random) {
 	const auto speed = RandomSpeed(descriptor, random);
 	return {
 		.start = (index * descriptor.framesCount * descriptor.frameDuration
@@ -161,11 +189,23 @@ struct Particle {
 	};
 }
 
-[[nodiscard]] QImage GenerateSprite(
+template <typename Random>
+[[nodiscard]] std::vector<Particle> GenerateParticles(
+		const SpoilerMessDescriptor &descriptor,
+		Random &&random) {
+	auto result = std::vector<Particle>();
+	result.reserve(descriptor.particlesCount);
+	for (auto i = 0; i != descriptor.particlesCount; ++i) {
+		result.push_back(GenerateParticle(descriptor, i, random));
+	}
+	return result;
+}
+
+// Sprites are white, so only the alpha channel is kept.
+[[nodiscard]] std::vector<uchar> GenerateSprite(
 		const SpoilerMessDescriptor &descriptor,
 		int index,
-		int size,
-		base::BufferedRandom<uint32> &random) {
+		int size) {
 	Expects(index >= 0 && index < descriptor.particleSpritesCount);
 
 	const auto count = descriptor.particleSpritesCount;
@@ -180,9 +220,9 @@ struct Particle {
 		: min;
 	const auto radius = min / 2.;
 
-	auto result = QImage(size, size, QImage::Format_ARGB32_Premultiplied);
-	result.fill(Qt::transparent);
-	auto p = QPainter(&result);
+	auto image = QImage(size, size, QImage::Format_ARGB32_Premultiplied);
+	image.fill(Qt::transparent);
+	auto p = QPainter(&image);
 	auto hq = PainterHighQualityEnabler(p);
 	p.setPen(Qt::NoPen);
 	p.setBrush(Qt::white);
@@ -190,9 +230,110 @@ struct Particle {
 	path.addRoundedRect(1., 1., width, height, radius, radius);
 	p.drawPath(path);
 	p.end();
+
+	auto result = std::vector<uchar>(size * size);
+	for (auto y = 0; y != size; ++y) {
+		const auto line = reinterpret_cast<const uint32*>(
+			image.constScanLine(y));
+		for (auto x = 0; x != size; ++x) {
+			result[y * size + x] = uchar(line[x] >> 24);
+		}
+	}
 	return result;
 }
 
+struct MessGenerator {
+	SpoilerMessDescriptor descriptor;
+	std::vector<Particle> particles;
+	std::vector<std::vector<uchar>> sprites;
+	uchar *bits = nullptr;
+	int bytesPerLine = 0;
+	int spriteSize = 0;
+	crl::time singleDuration = 0;
+	crl::time fullDuration = 0;
+
+	std::atomic<int> next = 0;
+	std::atomic<int> finished = 0;
+	std::mutex mutex;
+	std::condition_variable variable;
+};
+
+// Blends a white sprite over the frame canvas, wrapping around its edges.
+void PaintParticle(
+		const MessGenerator &generator,
+		uchar *canvas,
+		const Particle &particle,
+		crl::time now) {
+	const auto &descriptor = generator.descriptor;
+	const auto singleDuration = generator.singleDuration;
+	if (now <= 0 || now >= singleDuration) {
+		return;
+	}
+	const auto size = descriptor.canvasSize;
+	const auto clamp = [&](int value) {
+		return ((value % size) + size) % size;
+	};
+	const auto x = clamp(
+		particle.x + int(base::SafeRound(now * particle.dx)));
+	const auto y = clamp(
+		particle.y + int(base::SafeRound(now * particle.dy)));
+	const auto opacity = (now < descriptor.particleFadeInDuration)
+		? (now / float64(descriptor.particleFadeInDuration))
+		: (now > singleDuration - descriptor.particleFadeOutDuration)
+		? ((singleDuration - now)
+			/ float64(descriptor.particleFadeOutDuration))
+		: 1.;
+	const auto alpha = uint32(base::SafeRound(opacity * 256));
+	const auto spriteSize = generator.spriteSize;
+	const auto sprite = generator.sprites[particle.spriteIndex].data();
+	for (auto sy = 0; sy != spriteSize; ++sy) {
+		const auto from = sprite + sy * spriteSize;
+		const auto to = reinterpret_cast<uint32*>(
+			canvas + ((y + sy) % size) * generator.bytesPerLine);
+		for (auto sx = 0; sx != spriteSize; ++sx) {
+			const auto value = (from[sx] * alpha) >> 8;
+			if (!value) {
+				continue;
+			}
+			auto &pixel = to[(x + sx) % size];
+			const auto was = (pixel >> 24);
+			const auto result = value + ((was * (255 - value) + 127) / 255);
+			pixel = (result << 24) | (result << 16) | (result << 8) | result;
+		}
+	}
+}
+
+void GenerateMessFrame(const MessGenerator &generator, int frame) {
+	const auto &descriptor = generator.descriptor;
+	const auto size = descriptor.canvasSize;
+	const auto row = frame / kFramesPerRow;
+	const auto column = frame - row * kFramesPerRow;
+	const auto canvas = generator.bits
+		+ (row * size * generator.bytesPerLine)
+		+ (column * size * 4);
+	const auto time = frame * descriptor.frameDuration;
+	const auto full = generator.fullDuration;
+	for (const auto &particle : generator.particles) {
+		PaintParticle(generator, canvas, particle, time - particle.start);
+		PaintParticle(generator, canvas, particle, time + full - particle.start);
+	}
+}
+
+void GenerateMessFrames(const std::shared_ptr<MessGenerator> &generator) {
+	const auto frames = generator->descriptor.framesCount;
+	while (true) {
+		const auto frame = generator->next++;
+		if (frame >= frames) {
+			return;
+		}
+		GenerateMessFrame(*generator, frame);
+		if (++generator->finished == frames) {
+			auto lock = std::unique_lock(generator->mutex);
+			generator->variable.notify_all();
+		}
+	}
+}
+
 [[nodiscard]] QString DefaultMaskCacheFolder() {
 	const auto base = Integration::Instance().emojiCacheFolder();
 	return base.isEmpty() ? QString() : (base + "/spoiler");
@@ -348,78 +489,48 @@ SpoilerMessCached GenerateSpoilerMess(
 	const auto width = size * columns;
 	const auto height = size * rows;
 	const auto spriteSize = 2 + int(std::ceil(descriptor.particleSizeMax));
-	const auto singleDuration = descriptor.particleFadeInDuration
+	Assert(spriteSize <= size);
+
+	const auto generator = std::make_shared<MessGenerator>();
+	generator->descriptor = descriptor;
+	generator->spriteSize = spriteSize;
+	generator->singleDuration = descriptor.particleFadeInDuration
 		+ descriptor.particleShownDuration
 		+ descriptor.particleFadeOutDuration;
-	const auto fullDuration = frames * descriptor.frameDuration;
-	Assert(fullDuration > singleDuration);
-
-	auto random = base::BufferedRandom<uint32>(count * 5);
-
-	auto particles = std::vector<Particle>();
-	particles.reserve(descriptor.particlesCount);
-	for (auto i = 0; i != descriptor.particlesCount; ++i) {
-		particles.push_back(GenerateParticle(descriptor, i, random));
-	}
-
-	auto sprites = std::vector<QImage>();
-	sprites.reserve(descriptor.particleSpritesCount);
+	generator->fullDuration = frames * descriptor.frameDuration;
+	Assert(generator->fullDuration > generator->singleDuration);
+
+	generator->particles = descriptor.seed
+		? GenerateParticles(descriptor, SeededRandom(descriptor.seed))
+		: GenerateParticles(
+			descriptor,
+			base::BufferedRandom<uint32>(count * 5));
+	generator->sprites.reserve(descriptor.particleSpritesCount);
 	for (auto i = 0; i != descriptor.particleSpritesCount; ++i) {
-		sprites.push_back(GenerateSprite(descriptor, i, spriteSize, random));
+		generator->sprites.push_back(
+			GenerateSprite(descriptor, i, spriteSize));
 	}
 
-	auto frame = 0;
 	auto image = QImage(width, height, QImage::Format_ARGB32_Premultiplied);
 	image.fill(Qt::transparent);
-	auto p = QPainter(&image);
-	const auto paintOneAt = [&](const Particle &particle, crl::time now) {
-		if (now <= 0 || now >= singleDuration) {
-			return;
-		}
-		const auto clamp = [&](int value) {
-			return ((value % size) + size) % size;
-		};
-		const auto x = clamp(
-			particle.x + int(base::SafeRound(now * particle.dx)));
-		const auto y = clamp(
-			particle.y + int(base::SafeRound(now * particle.dy)));
-		const auto opacity = (now < descriptor.particleFadeInDuration)
-			? (now / float64(descriptor.particleFadeInDuration))
-			: (now > singleDuration - descriptor.particleFadeOutDuration)
-			? ((singleDuration - now)
-				/ float64(descriptor.particleFadeOutDuration))
-			: 1.;
-		p.setOpacity(opacity);
-		const auto &sprite = sprites[particle.spriteIndex];
-		p.drawImage(x, y, sprite);
-		if (x + spriteSize > size) {
-			p.drawImage(x - size, y, sprite);
-			if (y + spriteSize > size) {
-				p.drawImage(x, y - size, sprite);
-				p.drawImage(x - size, y - size, sprite);
-			}
-		} else if (y + spriteSize > size) {
-			p.drawImage(x, y - size, sprite);
-		}
-	};
-	const auto paintOne = [&](const Particle &particle, crl::time now) {
-		paintOneAt(particle, now - particle.start);
-		paintOneAt(particle, now + fullDuration - particle.start);
-	};
-	for (auto y = 0; y != rows; ++y) {
-		for (auto x = 0; x != columns; ++x) {
-			const auto rect = QRect(x * size, y * size, size, size);
-			p.setClipRect(rect);
-			p.translate(rect.topLeft());
-			const auto time = frame * descriptor.frameDuration;
-			for (auto index = 0; index != count; ++index) {
-				paintOne(particles[index], time);
-			}
-			p.translate(-rect.topLeft());
-			if (++frame >= frames) {
-				break;
-			}
-		}
+	generator->bits = image.bits();
+	generator->bytesPerLine = image.bytesPerLine();
+
+	// Frames are independent, each one is painted by a single thread,
+	// so the result doesn't depend on the way the work was split.
+	const auto helpers = std::min(
+		frames,
+		int(std::thread::hardware_concurrency())) - 1;
+	for (auto i = 0; i < helpers; ++i) {
+		crl::async([=] { GenerateMessFrames(generator); });
+	}
+	GenerateMessFrames(generator);
+	{
+		// Helpers that didn't take a frame don't touch the image.
+		auto lock = std::unique_lock(generator->mutex);
+		generator->variable.wait(lock, [&] {
+			return (generator->finished.load() == frames);
+		});
 	}
 	return SpoilerMessCached(
 		std::move(image),
@@ -438,73 +549,24 @@ void FillSpoilerRect(
 	}
 	const auto &image = *frame.image;
 	const auto source = frame.source;
+	Assert(image.depth() == 32);
+
+	// Wrap the frame without copying, the atlas outlives this call,
+	// and tile it over the whole rect with a single fill.
+	const auto tile = QImage(
+		image.constScanLine(source.y()) + source.x() * 4,
+		source.width(),
+		source.height(),
+		image.bytesPerLine(),
+		image.format());
 	const auto ratio = style::DevicePixelRatio();
 	const auto origin = rect.topLeft() + originShift;
-	const auto size = source.width() / ratio;
-	const auto xSkipFrames = (origin.x() <= rect.x())
-		? ((rect.x() - origin.x()) / size)
-		: -((origin.x() - rect.x() + size - 1) / size);
-	const auto ySkipFrames = (origin.y() <= rect.y())
-		? ((rect.y() - origin.y()) / size)
-		: -((origin.y() - rect.y() + size - 1) / size);
-	const auto xFrom = origin.x() + size * xSkipFrames;
-	const auto yFrom = origin.y() + size * ySkipFrames;
-	Assert((xFrom <= rect.x())
-		&& (yFrom <= rect.y())
-		&& (xFrom + size > rect.x())
-		&& (yFrom + size > rect.y()));
-	const auto xTill = rect.x() + rect.width();
-	const auto yTill = rect.y() + rect.height();
-	const auto xCount = (xTill - xFrom + size - 1) / size;
-	const auto yCount = (yTill - yFrom + size - 1) / size;
-	Assert(xCount > 0 && yCount > 0);
-	const auto xFullFrom = (xFrom < rect.x()) ? 1 : 0;
-	const auto yFullFrom = (yFrom < rect.y()) ? 1 : 0;
-	const auto xFullTill = xCount - (xFrom + xCount * size > xTill ? 1 : 0);
-	const auto yFullTill = yCount - (yFrom + yCount * size > yTill ? 1 : 0);
-	const auto targetRect = [&](int x, int y) {
-		return QRect(xFrom + x * size, yFrom + y * size, size, size);
-	};
-	const auto drawFull = [&](int x, int y) {
-		p.drawImage(targetRect(x, y), image, source);
-	};
-	const auto drawPart = [&](int x, int y) {
-		const auto target = targetRect(x, y);
-		const auto fill = target.intersected(rect);
-		Assert(!fill.isEmpty());
-		p.drawImage(fill, image, QRect(
-			source.topLeft() + ((fill.topLeft() - target.topLeft()) * ratio),
-			fill.size() * ratio));
-	};
-	if (yFullFrom) {
-		for (auto x = 0; x != xCount; ++x) {
-			drawPart(x, 0);
-		}
-	}
-	if (yFullFrom < yFullTill) {
-		if (xFullFrom) {
-			for (auto y = yFullFrom; y != yFullTill; ++y) {
-				drawPart(0, y);
-			}
-		}
-		if (xFullFrom < xFullTill) {
-			for (auto y = yFullFrom; y != yFullTill; ++y) {
-				for (auto x = xFullFrom; x != xFullTill; ++x) {
-					drawFull(x, y);
-				}
-			}
-		}
-		if (xFullFrom <= xFullTill && xFullTill < xCount) {
-			for (auto y = yFullFrom; y != yFullTill; ++y) {
-				drawPart(xFullTill, y);
-			}
-		}
-	}
-	if (yFullFrom <= yFullTill && yFullTill < yCount) {
-		for (auto x = 0; x != xCount; ++x) {
-			drawPart(x, yFullTill);
-		}
-	}
+	auto brush = QBrush(tile);
+	brush.setTransform(QTransform().translate(
+		origin.x(),
+		origin.y()
+	).scale(1. / ratio, 1. / ratio));
+	p.fillRect(rect, brush);
 }
 
 void FillSpoilerRect(
@@ -811,6 +873,15 @@ int SpoilerAnimation::index(crl::time now, bool paused) {
 	return absolute % kDefaultFramesCount;
 }
 
+void SpoilerAnimation::stop() {
+	_scheduled = false;
+	_last = 0;
+	if (_animating) {
+		_animating = false;
+		Unregister(this);
+	}
+}
+
 Fn<void()> SpoilerAnimation::repaintCallback() const {
 	return _repaint;
 }
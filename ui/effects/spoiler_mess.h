@@ -27,6 +27,7 @@ struct SpoilerMessDescriptor {
 	int canvasSize = 0;
 	int framesCount = 0;
 	crl::time frameDuration = 0;
+	uint64 seed = 0; // Non-zero gives the same result for the same seed.
 };
 
 struct SpoilerMessFrame {
@@ -91,6 +92,9 @@ public:
 
 	[[nodiscard]] int index(crl::time now, bool paused);
 
+	// Stops the ticks right away, the next index() call resumes them.
+	void stop();
+
 	[[nodiscard]] Fn<void()> repaintCallback() const;
 
 private:
@@ -13,8 +13,10 @@
 #include "base/debug_log.h"
 #include "ui/style/style_core.h"
 #include "ui/integration.h"
+#include "ui/main_queue_processor.h"
 #include "ui/painter.h"
 #include "ui/ui_utility.h"
+#include "ui/ui_trace.h"
 #include "styles/style_basic.h"
 
 #include <QtCore/QJsonDocument>
@@ -374,6 +376,41 @@ void ClearUniversalChecked() {
 	}
 }
 
+// Skips code units that can't start an emoji. Plain ASCII text is checked
+// four code units at once, as 16 bit lanes of a 64 bit word.
+[[nodiscard]] const QChar *SkipToEmojiCandidate(
+		const QChar *from,
+		const QChar *till) {
+	constexpr auto kLanes = 0x0001000100010001ULL;
+	constexpr auto kNotAscii = kLanes * 0xFF80ULL;
+	constexpr auto kHigh = kLanes * 0x8000ULL;
+	const auto skippable = [&](uint64 chunk) {
+		if (chunk & kNotAscii) {
+			return false;
+		}
+		// Lanes in ['#', '9'] may start an emoji (keycaps),
+		// "has between" bit hack for values below 0x8000.
+		constexpr auto kAbove = kLanes * (0x7FFFULL + '9' + 1);
+		constexpr auto kBelow = kLanes * (0x7FFFULL - '#' + 1);
+		return !((kAbove - chunk) & ~chunk & (chunk + kBelow) & kHigh);
+	};
+	while (from != till) {
+		if (till - from >= 4) {
+			auto chunk = uint64();
+			memcpy(&chunk, from, sizeof(chunk));
+			if (skippable(chunk)) {
+				from += 4;
+				continue;
+			}
+		}
+		if (MayStartEmoji(*from)) {
+			return from;
+		}
+		++from;
+	}
+	return till;
+}
+
 } // namespace
 
 namespace internal {
@@ -443,6 +480,7 @@ void UniversalImages::draw(
 }
 
 QImage UniversalImages::generate(int size, int index) const {
+	UI_TRACE_SCOPE("Emoji::generate");
 	Expects(size > 0);
 	Expects(index < _sprites.size());
 
@@ -487,6 +525,10 @@ void Init() {
 	internal::Init();
 
 	const auto count = internal::FullCount();
+	for (auto i = 0; i != count; ++i) {
+		const auto emoji = internal::ByIndex(i);
+		Assert(!emoji || MayStartEmoji(emoji->id()[0]));
+	}
 	const auto persprite = kImagesPerRow * kImageRowsPerSprite;
 	SpritesCount = (count / persprite) + ((count % persprite) ? 1 : 0);
 
@@ -655,6 +697,28 @@ EmojiPtr One::variant(int index) const {
 	return (index >= 0 && index <= variantsCount()) ? (original() + index) : this;
 }
 
+std::vector<FoundEmoji> FindAll(QStringView text) {
+	auto result = std::vector<FoundEmoji>();
+	const auto begin = text.begin();
+	const auto end = text.end();
+	auto ch = SkipToEmojiCandidate(begin, end);
+	while (ch != end) {
+		auto length = 0;
+		if (const auto emoji = internal::Find(ch, end, &length)) {
+			result.push_back({
+				.emoji = emoji,
+				.position = int(ch - begin),
+				.length = length,
+			});
+			ch += std::max(length, 1);
+		} else {
+			++ch;
+		}
+		ch = SkipToEmojiCandidate(ch, end);
+	}
+	return result;
+}
+
 QString IdFromOldKey(uint64 oldKey) {
 	auto code = uint32(oldKey >> 32);
 	auto code2 = uint32(oldKey & 0xFFFFFFFFLLU);
@@ -872,7 +936,7 @@ void Instance::generateCache() {
 		guard = _generating.make_guard()
 	]() mutable {
 		auto image = universal->generate(size, index);
-		crl::on_main(std::move(guard), [
+		PostToMainQueue(MainQueueLane::Paint, std::move(guard), [
 			=,
 			image = std::move(image)
 		]() mutable {
@@ -123,14 +123,38 @@ private:
 	return nullptr;
 }
 
+// First code units of all emoji, checked in Init().
+[[nodiscard]] inline bool MayStartEmoji(QChar ch) {
+	const auto code = ch.unicode();
+	if (code < 0x203C) {
+		return (code == '#')
+			|| (code == '*')
+			|| (code >= '0' && code <= '9')
+			|| (code == 0xA9)
+			|| (code == 0xAE);
+	}
+	return (code <= 0x3299) || (code >= 0xD83C && code <= 0xD83F);
+}
+
 [[nodiscard]] inline EmojiPtr Find(const QChar *start, const QChar *end, int *outLength = nullptr) {
-	return internal::Find(start, end, outLength);
+	return (start != end && MayStartEmoji(*start))
+		? internal::Find(start, end, outLength)
+		: nullptr;
 }
 
 [[nodiscard]] inline EmojiPtr Find(QStringView text, int *outLength = nullptr) {
 	return Find(text.begin(), text.end(), outLength);
 }
 
+struct FoundEmoji {
+	EmojiPtr emoji = nullptr;
+	int position = 0;
+	int length = 0;
+};
+
+// All emoji in the text, runs of plain text are skipped in bulk.
+[[nodiscard]] std::vector<FoundEmoji> FindAll(QStringView text);
+
 [[nodiscard]] QString IdFromOldKey(uint64 oldKey);
 
 [[nodiscard]] inline EmojiPtr FromOldKey(uint64 oldKey) {
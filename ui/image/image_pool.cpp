@@ -0,0 +1,159 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "ui/image/image_pool.h"
+
+#include <map>
+#include <mutex>
+
+namespace Images {
+namespace {
+
+constexpr auto kDefaultLimit = int64(32 * 1024 * 1024);
+constexpr auto kMinBucket = int64(4096);
+
+// Each buffer starts with a header keeping its bucket size,
+// the pixels follow it keeping the malloc() alignment.
+constexpr auto kHeaderSize = int64(alignof(std::max_align_t));
+
+struct Pool {
+	std::mutex mutex;
+	std::map<int64, std::vector<void*>> released;
+	int64 limit = kDefaultLimit;
+	int64 pooled = 0;
+	int64 inUse = 0;
+	int64 allocations = 0;
+	int64 reuses = 0;
+};
+
+[[nodiscard]] Pool &Instance() {
+	// Images may be destroyed after the static objects, never free it.
+	static const auto result = new Pool();
+	return *result;
+}
+
+// Rounds up to a quarter of the power of two, so that frames of
+// slightly different sizes share the same storage.
+[[nodiscard]] int64 BucketSize(int64 bytes) {
+	if (bytes <= kMinBucket) {
+		return kMinBucket;
+	}
+	auto power = kMinBucket;
+	while (power * 2 <= bytes) {
+		power *= 2;
+	}
+	const auto step = power / 4;
+	return ((bytes + step - 1) / step) * step;
+}
+
+[[nodiscard]] int64 &HeaderBucket(void *buffer) {
+	return *static_cast<int64*>(buffer);
+}
+
+[[nodiscard]] uchar *BufferPixels(void *buffer) {
+	return static_cast<uchar*>(buffer) + kHeaderSize;
+}
+
+void TrimReleased(Pool &pool) {
+	while (pool.pooled > pool.limit && !pool.released.empty()) {
+		const auto i = std::prev(end(pool.released));
+		std::free(i->second.back());
+		i->second.pop_back();
+		pool.pooled -= i->first;
+		if (i->second.empty()) {
+			pool.released.erase(i);
+		}
+	}
+}
+
+void ReleaseBuffer(void *buffer) {
+	auto &pool = Instance();
+	const auto bucket = HeaderBucket(buffer);
+
+	auto lock = std::unique_lock(pool.mutex);
+	pool.inUse -= bucket;
+	if (pool.pooled + bucket > pool.limit) {
+		lock.unlock();
+		std::free(buffer);
+		return;
+	}
+	pool.released[bucket].push_back(buffer);
+	pool.pooled += bucket;
+}
+
+} // namespace
+
+QImage PooledImage(QSize size, float64 ratio) {
+	if (size.isEmpty()) {
+		auto result = QImage(size, QImage::Format_ARGB32_Premultiplied);
+		result.setDevicePixelRatio(ratio);
+		return result;
+	}
+	const auto perLine = int64(size.width()) * 4;
+	const auto bucket = BucketSize(perLine * size.height());
+
+	auto &pool = Instance();
+	auto buffer = (void*)nullptr;
+	{
+		auto lock = std::unique_lock(pool.mutex);
+		const auto i = pool.released.find(bucket);
+		if (i != end(pool.released)) {
+			buffer = i->second.back();
+			i->second.pop_back();
+			if (i->second.empty()) {
+				pool.released.erase(i);
+			}
+			pool.pooled -= bucket;
+			++pool.reuses;
+		} else {
+			++pool.allocations;
+		}
+		pool.inUse += bucket;
+	}
+	if (!buffer) {
+		buffer = std::malloc(kHeaderSize + bucket);
+		if (!buffer) {
+			auto lock = std::unique_lock(pool.mutex);
+			pool.inUse -= bucket;
+			lock.unlock();
+
+			auto result = QImage(size, QImage::Format_ARGB32_Premultiplied);
+			result.setDevicePixelRatio(ratio);
+			return result;
+		}
+		HeaderBucket(buffer) = bucket;
+	}
+	auto result = QImage(
+		BufferPixels(buffer),
+		size.width(),
+		size.height(),
+		perLine,
+		QImage::Format_ARGB32_Premultiplied,
+		ReleaseBuffer,
+		buffer);
+	result.setDevicePixelRatio(ratio);
+	return result;
+}
+
+ImagePoolStats ImagePoolStatistics() {
+	auto &pool = Instance();
+	auto lock = std::unique_lock(pool.mutex);
+	return {
+		.allocations = pool.allocations,
+		.reuses = pool.reuses,
+		.bytesPooled = pool.pooled,
+		.bytesInUse = pool.inUse,
+	};
+}
+
+void SetImagePoolLimit(int64 bytes) {
+	auto &pool = Instance();
+	auto lock = std::unique_lock(pool.mutex);
+	pool.limit = std::max(bytes, int64(0));
+	TrimReleased(pool);
+}
+
+} // namespace Images
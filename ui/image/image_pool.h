@@ -0,0 +1,30 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+namespace Images {
+
+// Returns an uninitialized ARGB32_Premultiplied image which storage is
+// taken from a shared pool of released buffers. When the last copy of the
+// image is destroyed the storage goes back to the pool.
+//
+// Use it for short-living frames that are allocated again and again,
+// long-living cached images should be allocated the usual way.
+[[nodiscard]] QImage PooledImage(QSize size, float64 ratio = 1.);
+
+struct ImagePoolStats {
+	int64 allocations = 0;
+	int64 reuses = 0;
+	int64 bytesPooled = 0;
+	int64 bytesInUse = 0;
+};
+[[nodiscard]] ImagePoolStats ImagePoolStatistics();
+
+// Limits the size of released buffers kept for reuse, 32 MB by default.
+void SetImagePoolLimit(int64 bytes);
+
+} // namespace Images
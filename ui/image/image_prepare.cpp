@@ -9,6 +9,7 @@
 #include "ui/effects/animation_value.h"
 #include "ui/style/style_core.h"
 #include "ui/painter.h"
+#include "ui/ui_trace.h"
 #include "base/flat_map.h"
 #include "base/debug_log.h"
 #include "base/bytes.h"
@@ -1218,6 +1219,7 @@ QImage Opaque(QImage &&image) {
 }
 
 QImage Prepare(QImage image, int w, int h, const PrepareArgs &args) {
+	UI_TRACE_SCOPE("Images::Prepare");
 	Expects(!image.isNull());
 
 	if (args.options & Option::Blur) {
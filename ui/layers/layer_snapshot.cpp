@@ -0,0 +1,220 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "ui/layers/layer_snapshot.h"
+
+#include "ui/widgets/shadow.h"
+#include "ui/rp_widget.h"
+#include "ui/ui_utility.h"
+#include "styles/style_widgets.h"
+
+#include <QtGui/QBackingStore>
+#include <QtGui/QWindow>
+#include <qpa/qplatformbackingstore.h>
+#include <private/qwidget_p.h>
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+#include <private/qwidgetrepaintmanager_p.h>
+#else // Qt >= 6.0.0
+#include <private/qwidgetbackingstore_p.h>
+#endif // Qt < 6.0.0
+
+namespace Ui {
+namespace {
+
+constexpr auto kMaxPooledCount = 4;
+constexpr auto kMaxPooledBytes = int64(64 * 1024 * 1024);
+
+std::vector<QPixmap> Pool;
+
+[[nodiscard]] int64 SnapshotBytes(const QPixmap &pixmap) {
+	return int64(pixmap.width()) * pixmap.height() * 4;
+}
+
+[[nodiscard]] QPixmap AcquireSnapshot(QSize size) {
+	const auto ratio = style::DevicePixelRatio();
+	const auto pixels = size * ratio;
+	const auto i = ranges::find_if(Pool, [&](const QPixmap &pixmap) {
+		return (pixmap.size() == pixels) && pixmap.isDetached();
+	});
+	auto result = QPixmap();
+	if (i != end(Pool)) {
+		result = std::move(*i);
+		Pool.erase(i);
+	} else {
+		result = QPixmap(pixels);
+	}
+	result.setDevicePixelRatio(ratio);
+	return result;
+}
+
+[[nodiscard]] bool PresentedByNativeSurface(not_null<QWidget*> widget) {
+	return widget->testAttribute(Qt::WA_NativeWindow)
+		|| widget->inherits("QOpenGLWidget")
+		|| widget->inherits("QRhiWidget")
+		|| widget->inherits("QQuickWidget");
+}
+
+// Checks that 'rect' of 'body' on the screen shows only 'body' itself.
+[[nodiscard]] bool FullyPresented(
+		not_null<QWidget*> body,
+		QRect rect,
+		not_null<QWidget*> window) {
+	if (PresentedByNativeSurface(body)) {
+		return false;
+	}
+	for (const auto child : body->findChildren<QWidget*>()) {
+		if (child->isVisible()
+			&& !child->isWindow()
+			&& PresentedByNativeSurface(child)) {
+			return false;
+		}
+	}
+	const auto global = QRect(
+		body->mapTo(window, rect.topLeft()),
+		rect.size());
+	for (auto widget = body.get(); widget != window;) {
+		const auto parent = widget->parentWidget();
+		if (!parent) {
+			return false;
+		}
+		const auto &siblings = parent->children();
+		const auto i = ranges::find(siblings, widget);
+		const auto above = ranges::make_subrange(
+			(i == end(siblings)) ? i : (i + 1),
+			end(siblings));
+		for (const auto object : above) {
+			if (!object->isWidgetType()) {
+				continue;
+			}
+			const auto sibling = static_cast<QWidget*>(object);
+			if (sibling->isVisible()
+				&& !sibling->isWindow()
+				&& QRect(
+					sibling->mapTo(window, QPoint()),
+					sibling->size()).intersects(global)) {
+				return false;
+			}
+		}
+		widget = parent;
+	}
+	return true;
+}
+
+// The backing store contents are behind while some repaints are pending.
+[[nodiscard]] bool HasPendingUpdates(not_null<QWidget*> window) {
+	const auto d = QWidgetPrivate::get(window);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+	const auto manager = d->maybeRepaintManager();
+#else // Qt >= 6.0.0
+	const auto manager = d->maybeBackingStore();
+#endif // Qt < 6.0.0
+	return manager && manager->isDirty();
+}
+
+[[nodiscard]] QPixmap GrabFromBackingStore(
+		not_null<QWidget*> body,
+		QRect rect) {
+	const auto window = body->window();
+	const auto handle = window->windowHandle();
+	const auto store = window->backingStore();
+	if (!handle
+		|| !handle->isExposed()
+		|| (window->windowState() & Qt::WindowMinimized)
+		|| !store
+		|| !store->handle()
+		|| !body->updatesEnabled()
+		|| HasPendingUpdates(window)
+		|| !FullyPresented(body, rect, window)) {
+		return QPixmap();
+	}
+	const auto image = store->handle()->toImage();
+	const auto ratio = style::DevicePixelRatio();
+	if (image.isNull() || image.size() != window->size() * ratio) {
+		// Fractional scaling or a backing store without raster contents.
+		return QPixmap();
+	}
+	const auto position = body->mapTo(window, rect.topLeft());
+	const auto source = QRect(position * ratio, rect.size() * ratio);
+	if (!image.rect().contains(source)) {
+		return QPixmap();
+	}
+	auto result = AcquireSnapshot(rect.size());
+	{
+		QPainter p(&result);
+		p.setCompositionMode(QPainter::CompositionMode_Source);
+		p.drawImage(QRect(QPoint(), rect.size()), image, source);
+	}
+	return result;
+}
+
+} // namespace
+
+QPixmap GrabLayerBody(
+		not_null<QWidget*> body,
+		QRect rect,
+		bool fromBackingStore) {
+	SendPendingMoveResizeEvents(body);
+	rect = rect.isNull() ? body->rect() : rect.intersected(body->rect());
+	if (rect.isEmpty()) {
+		return QPixmap();
+	} else if (fromBackingStore) {
+		if (auto result = GrabFromBackingStore(body, rect)
+			; !result.isNull()) {
+			return result;
+		}
+	}
+	auto result = AcquireSnapshot(rect.size());
+	if (!body->testAttribute(Qt::WA_OpaquePaintEvent)) {
+		result.fill(Qt::transparent);
+	}
+	{
+		QPainter p(&result);
+		RenderWidget(p, body, QPoint(), rect);
+	}
+	return result;
+}
+
+QPixmap GrabLayerWithShadow(
+		not_null<RpWidget*> target,
+		const style::Shadow &shadow,
+		RectParts sides) {
+	SendPendingMoveResizeEvents(target);
+	const auto extend = QMargins(
+		(sides & RectPart::Left) ? shadow.extend.left() : 0,
+		(sides & RectPart::Top) ? shadow.extend.top() : 0,
+		(sides & RectPart::Right) ? shadow.extend.right() : 0,
+		(sides & RectPart::Bottom) ? shadow.extend.bottom() : 0);
+	const auto full = QRect(QPoint(), target->size()).marginsAdded(extend);
+	const auto outer = QRect(QPoint(), full.size());
+	auto result = AcquireSnapshot(outer.size());
+	result.fill(Qt::transparent);
+	{
+		QPainter p(&result);
+		Shadow::paint(p, outer.marginsRemoved(extend), outer.width(), shadow);
+		RenderWidget(p, target, QPoint(extend.left(), extend.top()));
+	}
+	return result;
+}
+
+void ReleaseLayerSnapshot(QPixmap &&snapshot) {
+	auto taken = base::take(snapshot);
+	if (taken.isNull() || !taken.isDetached()) {
+		return;
+	}
+	Pool.push_back(std::move(taken));
+	auto bytes = int64();
+	for (const auto &pixmap : Pool) {
+		bytes += SnapshotBytes(pixmap);
+	}
+	while (!Pool.empty()
+		&& (int(Pool.size()) > kMaxPooledCount || bytes > kMaxPooledBytes)) {
+		bytes -= SnapshotBytes(Pool.front());
+		Pool.erase(begin(Pool));
+	}
+}
+
+} // namespace Ui
@@ -0,0 +1,44 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+#include "ui/rect_part.h"
+
+namespace style {
+struct Shadow;
+} // namespace style
+
+namespace Ui {
+
+class RpWidget;
+
+// Snapshots for the LayerStackWidget show / hide animations.
+//
+// The pixmaps are taken from a small pool of released snapshots of the
+// same size, so opening the same box again doesn't allocate anything.
+
+// Grabs 'rect' of the 'body' widget. If 'body' is fully presented by its
+// window backing store (nothing is drawn above it and it has no native or
+// OpenGL children) the pixels are copied from there instead of repainting
+// the whole widget tree, unless the window has repaints still pending.
+// Pass 'fromBackingStore' = false when the caller has some of its own
+// widgets above 'body' that are already presented.
+[[nodiscard]] QPixmap GrabLayerBody(
+	not_null<QWidget*> body,
+	QRect rect,
+	bool fromBackingStore);
+
+// Same as Shadow::grab(), but uses the pooled storage.
+[[nodiscard]] QPixmap GrabLayerWithShadow(
+	not_null<RpWidget*> target,
+	const style::Shadow &shadow,
+	RectParts sides = RectPart::AllSides);
+
+// Returns a snapshot to the pool, if nobody else is holding it.
+void ReleaseLayerSnapshot(QPixmap &&snapshot);
+
+} // namespace Ui
@@ -8,6 +8,7 @@
 
 #include "ui/cached_special_layer_shadow_corners.h"
 #include "ui/layers/box_layer_widget.h"
+#include "ui/layers/layer_snapshot.h"
 #include "ui/widgets/shadow.h"
 #include "ui/image/image_prepare.h"
 #include "ui/painter.h"
@@ -26,6 +27,7 @@ namespace Ui {
 class LayerStackWidget::BackgroundWidget : public RpWidget {
 public:
 	using RpWidget::RpWidget;
+	~BackgroundWidget();
 
 	void setDoneCallback(Fn<void()> callback) {
 		_doneCallback = std::move(callback);
@@ -61,6 +63,7 @@ private:
 	void setLayerShown(bool shown);
 	void checkWasShown(bool wasShown);
 	void animationCallback();
+	void releaseCacheImages();
 
 	QPixmap _bodyCache;
 	QPixmap _mainMenuCache;
@@ -88,11 +91,23 @@ private:
 
 };
 
+LayerStackWidget::BackgroundWidget::~BackgroundWidget() {
+	releaseCacheImages();
+}
+
+void LayerStackWidget::BackgroundWidget::releaseCacheImages() {
+	ReleaseLayerSnapshot(base::take(_bodyCache));
+	ReleaseLayerSnapshot(base::take(_mainMenuCache));
+	ReleaseLayerSnapshot(base::take(_specialLayerCache));
+	ReleaseLayerSnapshot(base::take(_layerCache));
+}
+
 void LayerStackWidget::BackgroundWidget::setCacheImages(
 		QPixmap &&bodyCache,
 		QPixmap &&mainMenuCache,
 		QPixmap &&specialLayerCache,
 		QPixmap &&layerCache) {
+	releaseCacheImages();
 	_bodyCache = std::move(bodyCache);
 	_mainMenuCache = std::move(mainMenuCache);
 	_specialLayerCache = std::move(specialLayerCache);
@@ -105,7 +120,7 @@ void LayerStackWidget::BackgroundWidget::setCacheImages(
 
 void LayerStackWidget::BackgroundWidget::removeBodyCache() {
 	if (hasBodyCache()) {
-		_bodyCache = {};
+		ReleaseLayerSnapshot(base::take(_bodyCache));
 		setAttribute(Qt::WA_OpaquePaintEvent, false);
 	}
 }
@@ -116,6 +131,7 @@ bool LayerStackWidget::BackgroundWidget::hasBodyCache() const {
 
 void LayerStackWidget::BackgroundWidget::refreshBodyCache(
 		QPixmap &&bodyCache) {
+	ReleaseLayerSnapshot(base::take(_bodyCache));
 	_bodyCache = std::move(bodyCache);
 	setAttribute(Qt::WA_OpaquePaintEvent, !_bodyCache.isNull());
 }
@@ -155,7 +171,9 @@ void LayerStackWidget::BackgroundWidget::checkIfDone() {
 		return;
 	}
 	_wasAnimating = false;
-	_mainMenuCache = _specialLayerCache = _layerCache = QPixmap();
+	ReleaseLayerSnapshot(base::take(_mainMenuCache));
+	ReleaseLayerSnapshot(base::take(_specialLayerCache));
+	ReleaseLayerSnapshot(base::take(_layerCache));
 	removeBodyCache();
 	if (_doneCallback) {
 		_doneCallback();
@@ -438,7 +456,7 @@ void LayerStackWidget::hideAllAnimatedRun() {
 	if (_background->hasBodyCache()) {
 		removeBodyCache();
 		hideChildren();
-		auto bodyCache = Ui::GrabWidget(parentWidget());
+		auto bodyCache = GrabLayerBody(parentWidget(), geometry(), false);
 		showChildren();
 		_background->refreshBodyCache(std::move(bodyCache));
 	}
@@ -492,21 +510,32 @@ void LayerStackWidget::setCacheImages() {
 		if (_specialLayer->y() + _specialLayer->height() < height()) {
 			sides |= RectPart::Bottom;
 		}
-		specialLayerCache = Ui::Shadow::grab(_specialLayer, st::boxRoundShadow, sides);
+		specialLayerCache = GrabLayerWithShadow(
+			_specialLayer,
+			st::boxRoundShadow,
+			sides);
 	}
 	auto layerCache = QPixmap();
 	if (auto layer = currentLayer()) {
-		layerCache = Ui::Shadow::grab(layer, st::boxRoundShadow);
+		layerCache = GrabLayerWithShadow(layer, st::boxRoundShadow);
 	}
 	if (isAncestorOf(window()->focusWidget())) {
 		setFocus();
 	}
 	if (_mainMenu) {
+		// While we're hidden the window backing store shows the body.
+		const auto fromBackingStore = isHidden();
 		removeBodyCache();
 		hideChildren();
-		bodyCache = Ui::GrabWidget(parentWidget());
+		bodyCache = GrabLayerBody(
+			parentWidget(),
+			geometry(),
+			fromBackingStore);
 		showChildren();
-		mainMenuCache = Ui::Shadow::grab(_mainMenu, st::boxRoundShadow, RectPart::Right);
+		mainMenuCache = GrabLayerWithShadow(
+			_mainMenu,
+			st::boxRoundShadow,
+			RectPart::Right);
 	}
 	setAttribute(Qt::WA_OpaquePaintEvent, !bodyCache.isNull());
 	updateLayerBoxes();
@@ -15,17 +15,51 @@
 
 #include <crl/crl_on_main.h>
 
+#include <deque>
+
 namespace Ui {
 namespace {
 
+constexpr auto kDefaultPaintBudget = crl::time(8);
+constexpr auto kDefaultBackgroundBudget = crl::time(4);
+
 auto ProcessorEventType() {
 	static const auto Result = QEvent::Type(QEvent::registerEventType());
 	return Result;
 }
 
+auto LanesEventType() {
+	static const auto Result = QEvent::Type(QEvent::registerEventType());
+	return Result;
+}
+
+struct LaneItem {
+	FnMut<void()> callable;
+	crl::time queued = 0;
+};
+
+struct Lane {
+	std::deque<LaneItem> items;
+	int maxDepth = 0;
+	int64 processed = 0;
+	crl::time maxLatency = 0;
+};
+
 QMutex ProcessorMutex;
 MainQueueProcessor *ProcessorInstance/* = nullptr*/;
 
+// Guarded by ProcessorMutex.
+std::array<Lane, kMainQueueLanesCount> Lanes;
+bool LanesScheduled/* = false*/;
+Qt::EventPriority LanesScheduledPriority = Qt::LowEventPriority;
+crl::time PaintBudget = kDefaultPaintBudget;
+crl::time BackgroundBudget = kDefaultBackgroundBudget;
+int64 LanesDrains/* = 0*/;
+
+std::atomic<crl::time> MainQueueFilledAt/* = 0*/;
+std::atomic<int64> MainQueueDrains/* = 0*/;
+std::atomic<crl::time> MaxMainQueueLatency/* = 0*/;
+
 enum class ProcessState : int {
 	Processed,
 	FillingUp,
@@ -43,11 +77,15 @@ void PushToMainQueueGeneric(void (*callable)(void*), void *argument) {
 	const auto fill = MainQueueProcessState.compare_exchange_strong(
 		expected,
 		ProcessState::FillingUp);
-	if (fill) {
-		MainQueueProcessCallback = callable;
-		MainQueueProcessArgument = argument;
-		MainQueueProcessState.store(ProcessState::Waiting);
+	if (!fill) {
+		// The drain event is already posted and it will process
+		// everything that crl has enqueued by the time it runs.
+		return;
 	}
+	MainQueueProcessCallback = callable;
+	MainQueueProcessArgument = argument;
+	MainQueueFilledAt.store(crl::now());
+	MainQueueProcessState.store(ProcessState::Waiting);
 
 	auto event = std::make_unique<QEvent>(ProcessorEventType());
 
@@ -65,16 +103,115 @@ void DrainMainQueueGeneric() {
 	}
 	const auto callback = MainQueueProcessCallback;
 	const auto argument = MainQueueProcessArgument;
+	const auto latency = crl::now() - MainQueueFilledAt.load();
 	MainQueueProcessState.store(ProcessState::Processed);
 
+	++MainQueueDrains;
+	if (MaxMainQueueLatency.load() < latency) {
+		MaxMainQueueLatency.store(latency);
+	}
 	callback(argument);
 }
 
+[[nodiscard]] Qt::EventPriority LanePriority(MainQueueLane lane) {
+	switch (lane) {
+	case MainQueueLane::Input: return Qt::HighEventPriority;
+	case MainQueueLane::Paint: return Qt::NormalEventPriority;
+	case MainQueueLane::Background: return Qt::LowEventPriority;
+	}
+	Unexpected("Lane in LanePriority.");
+}
+
+// Should be called with ProcessorMutex locked.
+// If a drain is already posted with a lower priority, posts another one.
+void ScheduleLanesDrain(MainQueueLane lane) {
+	const auto priority = LanePriority(lane);
+	if (!ProcessorInstance
+		|| (LanesScheduled && LanesScheduledPriority >= priority)) {
+		return;
+	}
+	LanesScheduled = true;
+	LanesScheduledPriority = priority;
+	QCoreApplication::postEvent(
+		ProcessorInstance,
+		new QEvent(LanesEventType()),
+		priority);
+}
+
+// Should be called with ProcessorMutex locked.
+void ScheduleLanesDrainIfNeeded() {
+	for (auto i = 0; i != kMainQueueLanesCount; ++i) {
+		if (!Lanes[i].items.empty()) {
+			ScheduleLanesDrain(MainQueueLane(i));
+			return;
+		}
+	}
+}
+
+// Runs the items that were in the lane when the drain started, until
+// they're done or the deadline is reached. Items posted by the callbacks
+// wait for the next drain, so a callback re-posting itself can't keep
+// the event loop here, even in the Input lane that has no deadline.
+// Returns true if all of those items were processed.
+bool DrainLane(MainQueueLane index, crl::time deadline) {
+	auto &lane = Lanes[int(index)];
+	auto left = std::size_t();
+	{
+		QMutexLocker lock(&ProcessorMutex);
+		left = lane.items.size();
+	}
+	while (left > 0) {
+		auto item = LaneItem();
+		{
+			QMutexLocker lock(&ProcessorMutex);
+			if (lane.items.empty()) {
+				return true;
+			}
+			item = std::move(lane.items.front());
+			lane.items.pop_front();
+			++lane.processed;
+			lane.maxLatency = std::max(
+				lane.maxLatency,
+				crl::now() - item.queued);
+		}
+		--left;
+		item.callable();
+		if (deadline > 0 && crl::now() >= deadline) {
+			break;
+		}
+	}
+	return !left;
+}
+
+void DrainLanes() {
+	auto paintBudget = crl::time();
+	auto backgroundBudget = crl::time();
+	{
+		QMutexLocker lock(&ProcessorMutex);
+		LanesScheduled = false;
+		paintBudget = PaintBudget;
+		backgroundBudget = BackgroundBudget;
+		++LanesDrains;
+	}
+	DrainLane(MainQueueLane::Input, 0);
+	const auto paintDone = DrainLane(
+		MainQueueLane::Paint,
+		crl::now() + paintBudget);
+	if (paintDone) {
+		DrainLane(
+			MainQueueLane::Background,
+			crl::now() + backgroundBudget);
+	}
+
+	QMutexLocker lock(&ProcessorMutex);
+	ScheduleLanesDrainIfNeeded();
+}
+
 } // namespace
 
 MainQueueProcessor::MainQueueProcessor() {
+	acquire();
 	if constexpr (Platform::UseMainQueueGeneric()) {
-		acquire();
 		crl::init_main_queue(PushToMainQueueGeneric);
 	} else {
 		crl::wrap_main_queue([](void (*callable)(void*), void *argument) {
@@ -95,6 +232,10 @@ MainQueueProcessor::MainQueueProcessor() {
 }
 
 bool MainQueueProcessor::event(QEvent *event) {
+	if (event->type() == LanesEventType()) {
+		DrainLanes();
+		return true;
+	}
 	if constexpr (Platform::UseMainQueueGeneric()) {
 		if (event->type() == ProcessorEventType()) {
 			DrainMainQueueGeneric();
@@ -105,15 +246,17 @@ bool MainQueueProcessor::event(QEvent *event) {
 }
 
 void MainQueueProcessor::acquire() {
-	Expects(Platform::UseMainQueueGeneric());
 	Expects(ProcessorInstance == nullptr);
 
 	QMutexLocker lock(&ProcessorMutex);
 	ProcessorInstance = this;
+
+	// Items could be posted before the processor was created.
+	LanesScheduled = false;
+	ScheduleLanesDrainIfNeeded();
 }
 
 void MainQueueProcessor::release() {
-	Expects(Platform::UseMainQueueGeneric());
 	Expects(ProcessorInstance == this);
 
 	QMutexLocker lock(&ProcessorMutex);
@@ -121,9 +264,38 @@ void MainQueueProcessor::release() {
 }
 
 MainQueueProcessor::~MainQueueProcessor() {
-	if constexpr (Platform::UseMainQueueGeneric()) {
-		release();
+	release();
+}
+
+void PostToMainQueue(MainQueueLane lane, FnMut<void()> &&callable) {
+	QMutexLocker lock(&ProcessorMutex);
+	auto &items = Lanes[int(lane)].items;
+	items.push_back({ std::move(callable), crl::now() });
+	Lanes[int(lane)].maxDepth = std::max(
+		Lanes[int(lane)].maxDepth,
+		int(items.size()));
+	ScheduleLanesDrain(lane);
+}
+
+void SetMainQueueBudget(crl::time paint, crl::time background) {
+	QMutexLocker lock(&ProcessorMutex);
+	PaintBudget = std::max(paint, crl::time(1));
+	BackgroundBudget = std::max(background, crl::time(1));
+}
+
+MainQueueStats MainQueueStatistics() {
+	auto result = MainQueueStats();
+	QMutexLocker lock(&ProcessorMutex);
+	for (auto i = 0; i != kMainQueueLanesCount; ++i) {
+		result.depth[i] = int(Lanes[i].items.size());
+		result.maxDepth[i] = Lanes[i].maxDepth;
+		result.processed[i] = Lanes[i].processed;
+		result.maxLatency[i] = Lanes[i].maxLatency;
 	}
+	result.lanesDrains = LanesDrains;
+	result.mainQueueDrains = MainQueueDrains.load();
+	result.maxMainQueueLatency = MaxMainQueueLatency.load();
+	return result;
 }
 
 } // namespace Ui
@@ -6,6 +6,8 @@
 //
 #pragma once
 
+#include <crl/crl.h>
+
 namespace Ui {
 
 class MainQueueProcessor : public QObject {
@@ -24,4 +26,51 @@ private:
 
 };
 
+enum class MainQueueLane {
+	Input, // Processed all at once, before other lanes.
+	Paint, // Results that are visible right now.
+	Background, // Caches, prefetching and other work that may wait.
+};
+inline constexpr auto kMainQueueLanesCount = 3;
+
+// Thread-safe, runs the callback on the main thread. Paint and Background
+// lanes are drained in time slices, yielding to pending input and paint
+// events between the slices, so a burst of completions doesn't delay them.
+// Input lane drains are posted with a high event priority, Paint lane ones
+// with the normal priority and Background lane ones with a low priority.
+// Items posted to a lane while it is drained wait for its next drain.
+//
+// This is opt-in for work that can be reordered, crl::on_main() callbacks
+// are still processed the usual way, in the order they were posted.
+void PostToMainQueue(MainQueueLane lane, FnMut<void()> &&callable);
+
+template <
+	typename Guard,
+	typename Callable,
+	typename GuardTraits = crl::guard_traits<std::decay_t<Guard>>,
+	typename = std::enable_if_t<
+	sizeof(GuardTraits) != crl::details::dependent_zero<GuardTraits>>>
+inline void PostToMainQueue(
+		MainQueueLane lane,
+		Guard &&object,
+		Callable &&callable) {
+	return PostToMainQueue(lane, crl::guard(
+		std::forward<Guard>(object),
+		std::forward<Callable>(callable)));
+}
+
+// Time slices for a single drain of Paint and Background lanes.
+void SetMainQueueBudget(crl::time paint, crl::time background);
+
+struct MainQueueStats {
+	std::array<int, kMainQueueLanesCount> depth = {};
+	std::array<int, kMainQueueLanesCount> maxDepth = {};
+	std::array<int64, kMainQueueLanesCount> processed = {};
+	std::array<crl::time, kMainQueueLanesCount> maxLatency = {};
+	int64 lanesDrains = 0;
+	int64 mainQueueDrains = 0;
+	crl::time maxMainQueueLatency = 0;
+};
+[[nodiscard]] MainQueueStats MainQueueStatistics();
+
 } // namespace Ui
@@ -0,0 +1,160 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "ui/paint/paint_profiler.h"
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtGui/QtEvents>
+
+namespace Ui {
+namespace details {
+
+bool PaintProfilingEnabled = false;
+
+} // namespace details
+
+namespace {
+
+constexpr auto kMaxFrames = 100'000;
+
+struct PaintStats {
+	int64 paints = 0;
+	int64 area = 0;
+	int64 allocations = 0; // Including nested paints.
+	crl::profile_time total = 0; // Including nested paints.
+	crl::profile_time self = 0;
+	crl::profile_time max = 0;
+};
+
+struct Profile {
+	base::flat_map<QByteArray, PaintStats> classes;
+	std::vector<PaintStats> frames;
+	std::vector<crl::profile_time> nested;
+};
+
+Profile Data;
+Fn<int64()> AllocationsCounter;
+
+// Scopes opened before StartPaintProfiling() or StopPaintProfiling()
+// are ignored, so that they don't touch the 'nested' stack of another
+// session when the profiling is started or stopped during a paint.
+int Session = 0;
+
+[[nodiscard]] int64 CountAllocations() {
+	return AllocationsCounter ? AllocationsCounter() : 0;
+}
+
+void Accumulate(
+		PaintStats &stats,
+		int64 area,
+		int64 allocations,
+		crl::profile_time total) {
+	++stats.paints;
+	stats.area += area;
+	stats.allocations += allocations;
+	stats.total += total;
+	stats.max = std::max(stats.max, total);
+}
+
+[[nodiscard]] QJsonObject Serialize(const PaintStats &stats) {
+	auto result = QJsonObject();
+	result.insert("paints", double(stats.paints));
+	result.insert("area", double(stats.area));
+	result.insert("allocations", double(stats.allocations));
+	result.insert("total_us", double(stats.total));
+	result.insert("self_us", double(stats.self));
+	result.insert("max_us", double(stats.max));
+	return result;
+}
+
+} // namespace
+
+namespace details {
+
+PaintProfileScope::PaintProfileScope(
+	not_null<QWidget*> widget,
+	not_null<QPaintEvent*> e)
+: _className(widget->metaObject()->className())
+, _allocations(CountAllocations())
+, _started(crl::profile())
+, _session(Session) {
+	for (const auto &rect : e->region()) {
+		_area += int64(rect.width()) * rect.height();
+	}
+	Data.nested.push_back(0);
+}
+
+PaintProfileScope::~PaintProfileScope() {
+	if (!PaintProfilingEnabled
+		|| _session != Session
+		|| Data.nested.empty()) {
+		return;
+	}
+	const auto total = crl::profile() - _started;
+	const auto allocations = CountAllocations() - _allocations;
+	const auto self = total - Data.nested.back();
+	Data.nested.pop_back();
+	if (!Data.nested.empty()) {
+		Data.nested.back() += total;
+	}
+
+	auto &stats = Data.classes[QByteArray(_className)];
+	Accumulate(stats, _area, allocations, total);
+	stats.self += self;
+
+	if (Data.frames.empty()) {
+		Data.frames.emplace_back();
+	}
+	auto &frame = Data.frames.back();
+	Accumulate(frame, _area, allocations, total);
+	frame.self += self;
+}
+
+} // namespace details
+
+void StartPaintProfiling() {
+	++Session;
+	Data = Profile();
+	details::PaintProfilingEnabled = true;
+}
+
+void StopPaintProfiling() {
+	++Session;
+	details::PaintProfilingEnabled = false;
+	Data.nested.clear();
+}
+
+void SetPaintProfilingAllocationsCounter(Fn<int64()> counter) {
+	AllocationsCounter = std::move(counter);
+}
+
+void MarkPaintProfilingFrame() {
+	if (details::PaintProfilingEnabled
+		&& int(Data.frames.size()) < kMaxFrames) {
+		Data.frames.emplace_back();
+	}
+}
+
+QByteArray PaintProfilingJson() {
+	auto classes = QJsonArray();
+	for (const auto &[name, stats] : Data.classes) {
+		auto object = Serialize(stats);
+		object.insert("class", QString::fromLatin1(name));
+		classes.append(object);
+	}
+	auto frames = QJsonArray();
+	for (const auto &stats : Data.frames) {
+		frames.append(Serialize(stats));
+	}
+	auto result = QJsonObject();
+	result.insert("classes", classes);
+	result.insert("frames", frames);
+	return QJsonDocument(result).toJson(QJsonDocument::Indented);
+}
+
+} // namespace Ui
@@ -0,0 +1,54 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+#include <crl/crl_time.h>
+
+class QPaintEvent;
+
+namespace Ui {
+
+// Collects paint statistics of all RpWidget-s while enabled:
+// paint event count, paint time and repainted area, per widget class
+// and per frame. Frames are separated by MarkPaintProfilingFrame() calls,
+// so a headless harness can tick a ManualFrameClock, process the pending
+// paint events and mark the frame end, getting a reproducible trace.
+void StartPaintProfiling();
+void StopPaintProfiling();
+void MarkPaintProfilingFrame();
+[[nodiscard]] QByteArray PaintProfilingJson();
+
+// Heap allocations are not tracked by lib_ui itself. A harness that counts
+// them, for example in a replaced global operator new, can pass its counter
+// here to get allocation counts per widget class and per frame.
+void SetPaintProfilingAllocationsCounter(Fn<int64()> counter);
+
+namespace details {
+
+extern bool PaintProfilingEnabled;
+
+class PaintProfileScope final {
+public:
+	PaintProfileScope(not_null<QWidget*> widget, not_null<QPaintEvent*> e);
+	~PaintProfileScope();
+
+private:
+	const char *_className = nullptr;
+	int64 _area = 0;
+	int64 _allocations = 0;
+	crl::profile_time _started = 0;
+	int _session = 0;
+
+};
+
+} // namespace details
+
+[[nodiscard]] inline bool PaintProfiling() {
+	return details::PaintProfilingEnabled;
+}
+
+} // namespace Ui
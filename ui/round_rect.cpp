@@ -128,20 +128,35 @@ RoundRect::RoundRect(
 	ImageRoundRadius radius,
 	const style::color &color)
 : _color(color)
-, _refresh([=] { _corners = Images::PrepareCorners(radius, _color); }) {
+, _mask(Images::CornersMask(radius))
+, _refresh([=] { tintCorners(); }) {
+	_corners = _mask;
 	_refresh();
 	style::PaletteChanged(
-	) | rpl::on_next(_refresh, _lifetime);
+	) | rpl::filter([=] {
+		return style::PaletteColorChanged(_color);
+	}) | rpl::on_next(_refresh, _lifetime);
 }
 
 RoundRect::RoundRect(
 	int radius,
 	const style::color &color)
 : _color(color)
-, _refresh([=] { _corners = Images::PrepareCorners(radius, _color); }) {
+, _mask(Images::CornersMask(radius))
+, _refresh([=] { tintCorners(); }) {
+	_corners = _mask;
 	_refresh();
 	style::PaletteChanged(
-	) | rpl::on_next(_refresh, _lifetime);
+	) | rpl::filter([=] {
+		return style::PaletteColorChanged(_color);
+	}) | rpl::on_next(_refresh, _lifetime);
+}
+
+void RoundRect::tintCorners() {
+	// Colorize into the same images, only the first time they detach.
+	for (auto i = 0; i != 4; ++i) {
+		style::colorizeImage(_mask[i], _color->c, &_corners[i]);
+	}
 }
 
 void RoundRect::setColor(const style::color &color) {
@@ -45,7 +45,10 @@ public:
 		RectParts corners) const;
 
 private:
+	void tintCorners();
+
 	style::color _color;
+	std::array<QImage, 4> _mask;
 	std::array<QImage, 4> _corners;
 	Fn<void()> _refresh;
 
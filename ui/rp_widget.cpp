@@ -9,6 +9,7 @@
 #include "base/qt_signal_producer.h"
 #include "ui/accessible/ui_accessible_widget.h"
 #include "ui/gl/gl_detection.h"
+#include "ui/paint/paint_profiler.h"
 
 #include <QtGui/QWindow>
 #include <QtGui/QtEvents>
@@ -208,6 +209,10 @@ rpl::lifetime &RpWidgetWrap::lifetime() {
 bool RpWidgetWrap::handleEvent(QEvent *event) {
 	Expects(event != nullptr);
 
+	auto profile = std::optional<details::PaintProfileScope>();
+	if (event->type() == QEvent::Paint && PaintProfiling()) {
+		profile.emplace(rpWidget(), static_cast<QPaintEvent*>(event));
+	}
 	auto streams = _eventStreams.get();
 	if (!streams) {
 		return eventHook(event);
@@ -376,10 +376,11 @@ public:
 
 	// Updates the area that is visible inside the scroll container.
 	void setVisibleTopBottom(int visibleTop, int visibleBottom) {
-		const auto max = std::max(height(), 0);
-		visibleTopBottomUpdated(
-			std::clamp(visibleTop, 0, max),
-			std::clamp(visibleBottom, 0, max));
+		updateVisibleTopBottom(
+			visibleTop,
+			visibleBottom,
+			visibleTop,
+			visibleBottom);
 	}
 
 	[[nodiscard]] virtual QAccessibleInterface *accessibilityCreate();
@@ -409,10 +410,14 @@ protected:
 			int visibleTop,
 			int visibleBottom) {
 		if (child) {
+			// Containers pass the clamped range, restore what was
+			// clamped away to keep the children distances right.
 			auto top = child->y();
-			child->setVisibleTopBottom(
+			child->updateVisibleTopBottom(
 				visibleTop - top,
-				visibleBottom - top);
+				visibleBottom - top,
+				visibleTop - top + _visibleTopClamped,
+				visibleBottom - top + _visibleBottomClamped);
 		}
 	}
 
@@ -421,9 +426,34 @@ protected:
 		int visibleBottom) {
 	}
 
+	// Same as above, but not clamped to the widget, so that it is
+	// possible to find out how far the widget is from the visible area.
+	virtual void visibleDistanceUpdated(
+		int visibleTop,
+		int visibleBottom) {
+	}
+
 	template <typename OtherWidget, typename OtherTraits>
 	friend class RpWidgetBase;
 
+private:
+	void updateVisibleTopBottom(
+			int visibleTop,
+			int visibleBottom,
+			int distanceTop,
+			int distanceBottom) {
+		const auto max = std::max(height(), 0);
+		const auto top = std::clamp(visibleTop, 0, max);
+		const auto bottom = std::clamp(visibleBottom, 0, max);
+		_visibleTopClamped = distanceTop - top;
+		_visibleBottomClamped = distanceBottom - bottom;
+		visibleDistanceUpdated(distanceTop, distanceBottom);
+		visibleTopBottomUpdated(top, bottom);
+	}
+
+	int _visibleTopClamped = 0;
+	int _visibleBottomClamped = 0;
+
 };
 
 struct VisibleRange {
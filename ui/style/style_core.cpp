@@ -6,6 +6,7 @@
 //
 #include "ui/style/style_core.h"
 
+#include "ui/style/style_core_palette.h"
 #include "ui/effects/animation_value.h"
 #include "ui/painter.h"
 #include "styles/style_basic.h"
@@ -15,6 +16,7 @@
 
 #include <rpl/event_stream.h>
 #include <rpl/variable.h>
+#include <rpl/filter.h>
 
 namespace style {
 namespace internal {
@@ -26,6 +28,8 @@ constexpr auto kContrastDeltaL = 64;
 
 auto PaletteChanges = rpl::event_stream<>();
 auto PaletteVersion = 0;
+auto PaletteChangedColors = base::flat_set<int>();
+auto PaletteChangedAll = true;
 auto ShortAnimationRunning = rpl::variable<bool>(false);
 auto RunningShortAnimations = 0;
 
@@ -79,8 +83,32 @@ int PaletteVersion() {
 }
 
 void NotifyPaletteChanged() {
+	// Nothing tracked means we don't know, so everything has changed.
+	auto changed = main_palette::takeChangedColors();
+	internal::PaletteChangedAll = changed.empty();
+	internal::PaletteChangedColors = std::move(changed);
+
 	++internal::PaletteVersion;
 	internal::PaletteChanges.fire({});
+
+	internal::PaletteChangedAll = true;
+	internal::PaletteChangedColors.clear();
+}
+
+bool PaletteColorChanged(const color &c) {
+	return PaletteColorChanged(main_palette::indexOfColor(c));
+}
+
+bool PaletteColorChanged(int index) {
+	return internal::PaletteChangedAll
+		|| (index < 0)
+		|| internal::PaletteChangedColors.contains(index);
+}
+
+rpl::producer<> PaletteChanged(std::vector<color> colors) {
+	return PaletteChanged() | rpl::filter([colors = std::move(colors)] {
+		return ranges::any_of(colors, PaletteColorChanged);
+	});
 }
 
 rpl::producer<bool> ShortAnimationPlaying() {
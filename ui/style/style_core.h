@@ -42,6 +42,13 @@ void StopManager();
 [[nodiscard]] int PaletteVersion();
 void NotifyPaletteChanged();
 
+// While PaletteChanged() fires tells if this color was changed.
+[[nodiscard]] bool PaletteColorChanged(const color &c);
+[[nodiscard]] bool PaletteColorChanged(int mainPaletteIndex);
+
+// Fires only if any of the colors was changed.
+[[nodiscard]] rpl::producer<> PaletteChanged(std::vector<color> colors);
+
 [[nodiscard]] rpl::producer<bool> ShortAnimationPlaying();
 
 // *outResult must be r.width() x r.height(), ARGB32_Premultiplied.
@@ -16,6 +16,10 @@
 #include <QtCore/QDir>
 #include <QtGui/QFontInfo>
 #include <QtGui/QFontDatabase>
+#include <QtGui/QRawFont>
+
+#include <mutex>
+#include <unordered_map>
 
 #if __has_include(<glib.h>)
 #include <glib.h>
@@ -405,9 +409,40 @@ int RegisterFontFamily(const QString &family) {
 	return i->second;
 }
 
+struct FontData::MetricsCache {
+	static constexpr auto kSimpleFrom = 0x20;
+	static constexpr auto kSimpleTill = 0x7F;
+	static constexpr auto kMaxCachedLength = 256;
+	static constexpr auto kMaxCachedCount = 2048;
+
+	struct ElidedKey {
+		QString text;
+		int width = 0;
+		Qt::TextElideMode mode = Qt::ElideRight;
+
+		friend inline bool operator==(
+				const ElidedKey &a,
+				const ElidedKey &b) = default;
+	};
+	struct ElidedKeyHash {
+		size_t operator()(const ElidedKey &key) const {
+			return qHash(key.text, size_t(key.width) * 4 + key.mode);
+		}
+	};
+
+	// Printable ASCII advances, usable only if shaping can't change them.
+	std::array<float64, kSimpleTill - kSimpleFrom> simple = { { 0. } };
+	bool simpleValid = false;
+
+	std::mutex mutex;
+	std::unordered_map<QString, float64> advances;
+	std::unordered_map<ElidedKey, QString, ElidedKeyHash> elided;
+};
+
 FontData::FontData(const FontResolveResult &result, FontVariants *modified)
 : f(result.font)
 , _m(f)
+, _metrics(std::make_shared<MetricsCache>())
 , _size(result.requestedSize)
 , _family(result.requestedFamily)
 , _flags(result.requestedFlags) {
@@ -416,6 +451,22 @@ FontData::FontData(const FontResolveResult &result, FontVariants *modified)
 	}
 	_modified[int(_flags)] = Font(this);
 
+	// ASCII strings skip the shaping only if the font can't change
+	// the advances: it has no ligatures and no kerning that is applied.
+	const auto raw = QRawFont::fromFont(f);
+	_metrics->simpleValid = raw.isValid()
+		&& raw.fontTable("GSUB").isEmpty()
+		&& (!f.kerning()
+			|| (raw.fontTable("GPOS").isEmpty()
+				&& raw.fontTable("kern").isEmpty()));
+	if (_metrics->simpleValid) {
+		auto &simple = _metrics->simple;
+		for (auto i = 0; i != int(simple.size()); ++i) {
+			const auto ch = QChar(MetricsCache::kSimpleFrom + i);
+			simple[i] = _m.horizontalAdvance(ch);
+		}
+	}
+
 	height = int(base::SafeRound(result.height));
 	ascent = int(base::SafeRound(result.ascent));
 	descent = height - ascent;
@@ -423,6 +474,108 @@ FontData::FontData(const FontResolveResult &result, FontVariants *modified)
 	elidew = width(u"..."_q);
 }
 
+std::optional<float64> FontData::simpleAdvance(QStringView text) const {
+	const auto &metrics = *_metrics;
+	if (!metrics.simpleValid) {
+		return std::nullopt;
+	}
+	auto result = 0.;
+	for (const auto ch : text) {
+		const auto code = ch.unicode();
+		if (code < MetricsCache::kSimpleFrom
+			|| code >= MetricsCache::kSimpleTill) {
+			return std::nullopt;
+		}
+		result += metrics.simple[code - MetricsCache::kSimpleFrom];
+	}
+	return result;
+}
+
+float64 FontData::advance(const QString &text) const {
+	if (const auto simple = simpleAdvance(text)) {
+		return *simple;
+	} else if (text.size() > MetricsCache::kMaxCachedLength) {
+		return _m.horizontalAdvance(text);
+	}
+	auto &metrics = *_metrics;
+	auto lock = std::unique_lock(metrics.mutex);
+	if (const auto i = metrics.advances.find(text)
+		; i != end(metrics.advances)) {
+		return i->second;
+	}
+	lock.unlock();
+	const auto result = _m.horizontalAdvance(text);
+	lock.lock();
+	if (metrics.advances.size() >= MetricsCache::kMaxCachedCount) {
+		metrics.advances.clear();
+	}
+	metrics.advances.emplace(text, result);
+	return result;
+}
+
+int FontData::width(const QString &text) const {
+	return int(std::ceil(advance(text)));
+}
+
+int FontData::width(const QString &text, int from, int to) const {
+	// Same bounds as in QString::mid(from, to).
+	const auto size = int(text.size());
+	auto start = from;
+	auto length = to;
+	if (start > size) {
+		start = length = 0;
+	} else if (start < 0) {
+		if (length < 0 || length + start >= size) {
+			start = 0;
+			length = size;
+		} else if (length + start <= 0) {
+			start = length = 0;
+		} else {
+			length += start;
+			start = 0;
+		}
+	} else if (length < 0 || length > size - start) {
+		length = size - start;
+	}
+	const auto simple = simpleAdvance(QStringView(text).mid(start, length));
+	return simple
+		? int(std::ceil(*simple))
+		: width(text.mid(from, to));
+}
+
+int FontData::width(QChar ch) const {
+	const auto code = ch.unicode();
+	return (_metrics->simpleValid
+		&& code >= MetricsCache::kSimpleFrom
+		&& code < MetricsCache::kSimpleTill)
+		? int(std::ceil(
+			_metrics->simple[code - MetricsCache::kSimpleFrom]))
+		: int(std::ceil(_m.horizontalAdvance(ch)));
+}
+
+QString FontData::elided(
+		const QString &str,
+		int width,
+		Qt::TextElideMode mode) const {
+	if (str.size() > MetricsCache::kMaxCachedLength) {
+		return _m.elidedText(str, mode, width);
+	}
+	auto &metrics = *_metrics;
+	auto key = MetricsCache::ElidedKey{ str, width, mode };
+	auto lock = std::unique_lock(metrics.mutex);
+	if (const auto i = metrics.elided.find(key); i != end(metrics.elided)) {
+		return i->second;
+	}
+	lock.unlock();
+	auto result = _m.elidedText(str, mode, width);
+	lock.lock();
+	if (metrics.elided.size() >= MetricsCache::kMaxCachedCount) {
+		metrics.elided.clear();
+	}
+	metrics.elided.emplace(std::move(key), result);
+	return result;
+}
+
 Font FontData::bold(bool set) const {
 	return otherFlagsFont(FontFlag::Bold, set);
 }
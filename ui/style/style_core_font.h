@@ -13,6 +13,7 @@
 #include <QtGui/QFontMetrics>
 
 #include <cmath>
+#include <optional>
 
 namespace style {
 
@@ -92,21 +93,13 @@ private:
 
 class FontData {
 public:
-	[[nodiscard]] int width(const QString &text) const {
-		return int(std::ceil(_m.horizontalAdvance(text)));
-	}
-	[[nodiscard]] int width(const QString &text, int from, int to) const {
-		return width(text.mid(from, to));
-	}
-	[[nodiscard]] int width(QChar ch) const {
-		return int(std::ceil(_m.horizontalAdvance(ch)));
-	}
+	[[nodiscard]] int width(const QString &text) const;
+	[[nodiscard]] int width(const QString &text, int from, int to) const;
+	[[nodiscard]] int width(QChar ch) const;
 	[[nodiscard]] QString elided(
-			const QString &str,
-			int width,
-			Qt::TextElideMode mode = Qt::ElideRight) const {
-		return _m.elidedText(str, mode, width);
-	}
+		const QString &str,
+		int width,
+		Qt::TextElideMode mode = Qt::ElideRight) const;
 
 	[[nodiscard]] Font bold(bool set = true) const;
 	[[nodiscard]] Font italic(bool set = true) const;
@@ -130,12 +123,19 @@ private:
 	friend class OwnedFont;
 	friend struct ResolvedFont;
 
+	struct MetricsCache;
+
 	mutable FontVariants _modified;
 
 	[[nodiscard]] Font otherFlagsFont(FontFlag flag, bool set) const;
 	FontData(const FontResolveResult &data, FontVariants *modified);
 
+	[[nodiscard]] std::optional<float64> simpleAdvance(
+		QStringView text) const;
+	[[nodiscard]] float64 advance(const QString &text) const;
+
 	QFontMetricsF _m;
+	std::shared_ptr<MetricsCache> _metrics;
 	int _size = 0;
 	int _family = 0;
 	FontFlags _flags = 0;
@@ -8,13 +8,18 @@
 
 #include "ui/style/style_core_palette.h"
 #include "ui/style/style_core.h"
+#include "ui/main_queue_processor.h"
 #include "ui/painter.h"
 #include "base/basic_types.h"
 
-#include <QtCore/QMutex>
 #include <QtGui/QPainter>
 #include <QtSvg/QSvgRenderer>
 
+#include <crl/crl_async.h>
+#include <atomic>
+#include <shared_mutex>
+#include <unordered_map>
+
 namespace style {
 namespace internal {
 namespace {
@@ -26,11 +31,40 @@ namespace {
 		| uint32(c.alpha());
 }
 
-base::flat_map<const IconMask*, QImage> IconMasks;
-QMutex IconMasksMutex;
+struct IconPixmapKey {
+	const IconMask *mask = nullptr;
+	uint32 color = 0;
+
+	friend inline bool operator==(
+		const IconPixmapKey &a,
+		const IconPixmapKey &b) = default;
+};
 
-base::flat_map<QPair<const IconMask*, uint32>, QPixmap> iconPixmaps;
+struct IconPixmapKeyHash {
+	size_t operator()(const IconPixmapKey &key) const {
+		return std::hash<const void*>()(key.mask)
+			^ (size_t(key.color) * 0x9E3779B1U);
+	}
+};
+
+// Masks are resolved from the main thread and from PrewarmIcons workers.
+// The generation and scale are changed only from the main thread and
+// under the mutex, so that a worker that started before DestroyIcons()
+// or a scale change doesn't put a stale mask back.
+std::unordered_map<const IconMask*, QImage> IconMasks;
+std::shared_mutex IconMasksMutex;
+int IconMasksGeneration = 0;
+int IconMasksScale = 0;
+std::atomic<int> IconMaskMisses = 0;
+
+std::unordered_map<IconPixmapKey, QPixmap, IconPixmapKeyHash> iconPixmaps;
 base::flat_set<IconData*> iconData;
+int IconPixmapMisses = 0;
+int IconPixmapsGeneration = 0;
+
+// While a palette transition is running the colors of its steps are not
+// put to iconPixmaps, the icons are tinted into their own scratch images.
+bool IconsRetinting = false;
 
 [[nodiscard]] QImage CreateIconMask(
 		not_null<const IconMask*> mask,
@@ -110,15 +144,39 @@ base::flat_set<IconData*> iconData;
 		Qt::SmoothTransformation);
 }
 
-[[nodiscard]] QImage ResolveIconMask(not_null<const IconMask*> mask) {
-	QMutexLocker lock(&IconMasksMutex);
-	if (const auto i = IconMasks.find(mask); i != end(IconMasks)) {
-		return i->second;
+// Main thread only.
+[[nodiscard]] int IconMasksGenerationForScale(int scale) {
+	if (IconMasksScale != scale) {
+		auto lock = std::unique_lock(IconMasksMutex);
+		IconMasksScale = scale;
+		++IconMasksGeneration;
+		IconMasks.clear();
 	}
-	return IconMasks.emplace(
-		mask,
-		CreateIconMask(mask, Scale())
-	).first->second;
+	return IconMasksGeneration;
+}
+
+[[nodiscard]] QImage ResolveIconMask(
+		not_null<const IconMask*> mask,
+		int scale,
+		int generation) {
+	{
+		auto lock = std::shared_lock(IconMasksMutex);
+		if (generation == IconMasksGeneration) {
+			const auto i = IconMasks.find(mask);
+			if (i != end(IconMasks)) {
+				return i->second;
+			}
+		}
+	}
+	++IconMaskMisses;
+
+	// Decode without holding the lock, the first inserted result wins.
+	auto image = CreateIconMask(mask, scale);
+	auto lock = std::unique_lock(IconMasksMutex);
+	if (generation != IconMasksGeneration) {
+		return image;
+	}
+	return IconMasks.emplace(mask, std::move(image)).first->second;
 }
 
 [[nodiscard]] QSize readGeneratedSize(
@@ -177,6 +235,14 @@ MonoIcon::MonoIcon(const IconMask *mask, Color color, QMargins padding)
 void MonoIcon::reset() const {
 	_pixmap = QPixmap();
 	_size = QSize();
+	_tinted = false;
+}
+
+void MonoIcon::resetIfColorChanged() const {
+	const auto index = main_palette::indexOfColor(_color);
+	if (main_palette::colorChanged(index) || (_tinted && !IconsRetinting)) {
+		reset();
+	}
 }
 
 int MonoIcon::width() const {
@@ -206,8 +272,11 @@ void MonoIcon::paint(QPainter &p, const QPoint &pos, int outerw) const {
 	const auto partPosY = pos.y() + _padding.top();
 
 	ensureLoaded();
-	if (_pixmap.isNull()) {
+	if (_maskImage.isNull()) {
 		p.fillRect(QRect(QPoint(partPosX, partPosY), inner()), _color);
+	} else if (_tinted) {
+		ensureColorizedImage(_color->c);
+		p.drawImage(partPosX, partPosY, _colorizedImage);
 	} else {
 		p.drawPixmap(partPosX, partPosY, _pixmap);
 	}
@@ -217,8 +286,11 @@ void MonoIcon::fill(QPainter &p, const QRect &rect) const {
 	Expects(_padding.isNull());
 
 	ensureLoaded();
-	if (_pixmap.isNull()) {
+	if (_maskImage.isNull()) {
 		p.fillRect(rect, _color);
+	} else if (_tinted) {
+		ensureColorizedImage(_color->c);
+		p.drawImage(rect, _colorizedImage);
 	} else {
 		p.drawPixmap(rect, _pixmap);
 	}
@@ -235,7 +307,7 @@ void MonoIcon::paint(
 	const auto partPosY = pos.y() + _padding.top();
 
 	ensureLoaded();
-	if (_pixmap.isNull()) {
+	if (_maskImage.isNull()) {
 		p.fillRect(
 			QRect(QPoint(partPosX, partPosY), inner()),
 			colorOverride);
@@ -252,7 +324,7 @@ void MonoIcon::fill(
 	Expects(_padding.isNull());
 
 	ensureLoaded();
-	if (_pixmap.isNull()) {
+	if (_maskImage.isNull()) {
 		p.fillRect(rect, colorOverride);
 	} else {
 		ensureColorizedImage(colorOverride);
@@ -313,6 +385,25 @@ void MonoIcon::fill(
 	}
 }
 
+std::optional<IconPrewarmPart> MonoIcon::prewarmPart() const {
+	if (_size.isValid()
+		|| !_maskImage.isNull()
+		|| !readGeneratedSize(_mask, Scale()).isEmpty()) {
+		return std::nullopt;
+	}
+	return IconPrewarmPart{ _mask, _color->c };
+}
+
+IconShapePart MonoIcon::shapePart() const {
+	return {
+		.mask = _mask,
+		.paddingLeft = _padding.left(),
+		.paddingTop = _padding.top(),
+		.paddingRight = _padding.right(),
+		.paddingBottom = _padding.bottom(),
+	};
+}
+
 QImage MonoIcon::instance(
 		QColor colorOverride,
 		int scale,
@@ -326,7 +417,7 @@ QImage MonoIcon::instance(
 			size() * ratio,
 			QImage::Format_ARGB32_Premultiplied);
 		result.setDevicePixelRatio(ratio);
-		if (_pixmap.isNull()) {
+		if (_maskImage.isNull()) {
 			if (_padding.isNull()) {
 				result.fill(colorOverride);
 			} else {
@@ -378,7 +469,11 @@ void MonoIcon::ensureLoaded() const {
 	if (!_size.isEmpty()) {
 		_size = _size.grownBy(_padding);
 	} else {
-		_maskImage = ResolveIconMask(_mask);
+		const auto scale = Scale();
+		_maskImage = ResolveIconMask(
+			_mask,
+			scale,
+			IconMasksGenerationForScale(scale));
 		createCachedPixmap();
 	}
 }
@@ -388,14 +483,24 @@ void MonoIcon::ensureColorizedImage(QColor color) const {
 		_colorizedImage = QImage(
 			_maskImage.size(),
 			QImage::Format_ARGB32_Premultiplied);
+	} else if (_colorizedColor == color) {
+		return;
 	}
+	_colorizedColor = color;
 	colorizeImage(_maskImage, color, &_colorizedImage);
 }
 
 void MonoIcon::createCachedPixmap() const {
-	auto key = qMakePair(_mask, ColorKey(_color->c));
+	if (IconsRetinting) {
+		_tinted = true;
+		_pixmap = QPixmap();
+		_size = (_maskImage.size() / DevicePixelRatio()).grownBy(_padding);
+		return;
+	}
+	const auto key = IconPixmapKey{ _mask, ColorKey(_color->c) };
 	auto j = iconPixmaps.find(key);
 	if (j == end(iconPixmaps)) {
+		++IconPixmapMisses;
 		auto image = colorizeImage(_maskImage, _color);
 		j = iconPixmaps.emplace(
 			key,
@@ -499,19 +604,96 @@ void Icon::paintInCenter(
 }
 
 void ResetIcons() {
+	++IconPixmapsGeneration;
+	IconsRetinting = false;
 	iconPixmaps.clear();
 	for (const auto data : iconData) {
-		data->reset();
+		data->resetIfColorChanged();
+	}
+}
+
+void RetintIcons() {
+	IconsRetinting = true;
+	for (const auto data : iconData) {
+		data->resetIfColorChanged();
 	}
 }
 
 void DestroyIcons() {
+	++IconPixmapsGeneration;
 	iconData.clear();
 	iconPixmaps.clear();
 
-	QMutexLocker lock(&IconMasksMutex);
+	auto lock = std::unique_lock(IconMasksMutex);
+	++IconMasksGeneration;
 	IconMasks.clear();
 }
 
 } // namespace internal
+
+void PrewarmIcons(std::vector<not_null<const internal::Icon*>> icons) {
+	using namespace internal;
+
+	auto parts = std::vector<IconPrewarmPart>();
+	for (const auto icon : icons) {
+		icon->collectPrewarm(parts);
+	}
+	parts.erase(ranges::remove_if(parts, [](const IconPrewarmPart &part) {
+		const auto key = IconPixmapKey{ part.mask, ColorKey(part.color) };
+		return iconPixmaps.contains(key);
+	}), end(parts));
+	if (parts.empty()) {
+		return;
+	}
+	const auto generation = IconPixmapsGeneration;
+	const auto scale = Scale();
+	const auto masksGeneration = IconMasksGenerationForScale(scale);
+	crl::async([=, parts = std::move(parts)] {
+		struct Prepared {
+			IconPixmapKey key;
+			QImage image;
+		};
+		auto prepared = std::vector<Prepared>();
+		prepared.reserve(parts.size());
+		for (const auto &part : parts) {
+			const auto mask = ResolveIconMask(
+				part.mask,
+				scale,
+				masksGeneration);
+			prepared.push_back({
+				.key = { part.mask, ColorKey(part.color) },
+				.image = colorizeImage(mask, part.color),
+			});
+		}
+		auto publish = [=, prepared = std::move(prepared)]() mutable {
+			if (generation != IconPixmapsGeneration || IconsRetinting) {
+				return;
+			}
+			for (auto &[key, image] : prepared) {
+				if (!iconPixmaps.contains(key)) {
+					iconPixmaps.emplace(
+						key,
+						QPixmap::fromImage(std::move(image)));
+				}
+			}
+		};
+		Ui::PostToMainQueue(
+			Ui::MainQueueLane::Background,
+			std::move(publish));
+	});
+}
+
+IconCacheStats IconCacheStatistics() {
+	using namespace internal;
+
+	auto result = IconCacheStats{
+		.pixmaps = int(iconPixmaps.size()),
+		.maskMisses = IconMaskMisses.load(),
+		.pixmapMisses = IconPixmapMisses,
+	};
+	auto lock = std::shared_lock(IconMasksMutex);
+	result.masks = int(IconMasks.size());
+	return result;
+}
+
 } // namespace style
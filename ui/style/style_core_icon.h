@@ -11,6 +11,8 @@
 #include "base/algorithm.h"
 #include "base/assertion.h"
 
+#include <compare>
+#include <optional>
 #include <vector>
 
 namespace style {
@@ -36,6 +38,27 @@ private:
 
 };
 
+struct IconPrewarmPart {
+	not_null<const IconMask*> mask;
+	QColor color;
+};
+
+// Identifies the icon part shape without the color, the masks are static.
+struct IconShapePart {
+	const IconMask *mask = nullptr;
+	int paddingLeft = 0;
+	int paddingTop = 0;
+	int paddingRight = 0;
+	int paddingBottom = 0;
+
+	friend inline std::strong_ordering operator<=>(
+		const IconShapePart &a,
+		const IconShapePart &b) = default;
+	friend inline bool operator==(
+		const IconShapePart &a,
+		const IconShapePart &b) = default;
+};
+
 class MonoIcon {
 public:
 	MonoIcon() = default;
@@ -47,6 +70,7 @@ public:
 	MonoIcon(const IconMask *mask, Color color, QMargins padding);
 
 	void reset() const;
+	void resetIfColorChanged() const;
 	[[nodiscard]] int width() const;
 	[[nodiscard]] int height() const;
 	[[nodiscard]] QSize size() const;
@@ -76,6 +100,10 @@ public:
 		int scale,
 		bool ignoreDpr) const;
 
+	// Not loaded yet and not a generated (plain color) icon.
+	[[nodiscard]] std::optional<IconPrewarmPart> prewarmPart() const;
+	[[nodiscard]] IconShapePart shapePart() const;
+
 	~MonoIcon() {
 	}
 
@@ -89,8 +117,10 @@ private:
 	Color _color;
 	QMargins _padding = { 0, 0, 0, 0 };
 	mutable QImage _maskImage, _colorizedImage;
+	mutable QColor _colorizedColor;
 	mutable QPixmap _pixmap; // for pixmaps
 	mutable QSize _size; // for rects
+	mutable bool _tinted = false; // _colorizedImage instead of _pixmap
 
 };
 
@@ -111,6 +141,11 @@ public:
 			part.reset();
 		}
 	}
+	void resetIfColorChanged() {
+		for (const auto &part : _parts) {
+			part.resetIfColorChanged();
+		}
+	}
 	bool empty() const {
 		return _parts.empty();
 	}
@@ -152,6 +187,19 @@ public:
 		int scale,
 		bool ignoreDpr) const;
 
+	void collectPrewarm(std::vector<IconPrewarmPart> &parts) const {
+		for (const auto &part : _parts) {
+			if (auto prewarm = part.prewarmPart()) {
+				parts.push_back(*prewarm);
+			}
+		}
+	}
+	void collectShape(std::vector<IconShapePart> &parts) const {
+		for (const auto &part : _parts) {
+			parts.push_back(part.shapePart());
+		}
+	}
+
 	int width() const;
 	int height() const;
 
@@ -317,6 +365,17 @@ public:
 
 	Icon withPalette(const style::palette &palette) const;
 
+	void collectPrewarm(std::vector<IconPrewarmPart> &parts) const {
+		_data->collectPrewarm(parts);
+	}
+	[[nodiscard]] std::vector<IconShapePart> shape() const {
+		auto result = std::vector<IconShapePart>();
+		if (_data) {
+			_data->collectShape(result);
+		}
+		return result;
+	}
+
 	~Icon() {
 		if (auto data = base::take(_data)) {
 			if (_owner) {
@@ -368,7 +427,26 @@ private:
 };
 
 void ResetIcons();
+
+// A palette transition step. Resets only the icons whose color changed,
+// they are tinted from their masks into their own images, not into the
+// shared pixmaps, until the next ResetIcons() ends the transition.
+void RetintIcons();
+
 void DestroyIcons();
 
 } // namespace internal
+
+// Decodes masks and prepares colorized images on worker threads,
+// so that the first paint of these icons doesn't do that on main.
+void PrewarmIcons(std::vector<not_null<const internal::Icon*>> icons);
+
+struct IconCacheStats {
+	int masks = 0;
+	int pixmaps = 0;
+	int maskMisses = 0;
+	int pixmapMisses = 0;
+};
+[[nodiscard]] IconCacheStats IconCacheStatistics();
+
 } // namespace style
@@ -7,6 +7,9 @@
 #include "ui/style/style_core_palette.h"
 
 #include "ui/style/style_palette_colorizer.h"
+#include "ui/effects/animations.h"
+
+#include <crl/crl_on_main.h>
 
 namespace style {
 
@@ -54,6 +57,7 @@ void palette::finalize() {
 
 palette &palette::operator=(const palette &other) {
 	auto wasReady = _ready;
+	const auto was = wasReady ? save() : QByteArray();
 	for (int i = 0; i != kCount; ++i) {
 		if (other._status[i] != Status::Initial) {
 			if (_status[i] == Status::Initial) {
@@ -71,6 +75,7 @@ palette &palette::operator=(const palette &other) {
 	if (wasReady && !_ready) {
 		finalize();
 	}
+	markChangedFrom(was);
 	return *this;
 }
 
@@ -136,13 +141,68 @@ palette::SetResult palette::setColor(QLatin1String name, QLatin1String from) {
 }
 
 void palette::reset(const colorizer &with) {
+	const auto was = _ready ? save() : QByteArray();
 	clear();
 	finalize(with);
+	markChangedFrom(was);
 }
 
 void palette::reset() {
-	clear();
-	finalize();
+	reset(colorizer());
+}
+
+void palette::interpolate(
+		const palette &from,
+		const palette &to,
+		float64 progress) {
+	for (auto i = 0; i != kCount; ++i) {
+		if (from._status[i] == Status::Initial
+			|| to._status[i] == Status::Initial) {
+			continue;
+		}
+		const auto color = anim::color(
+			from.data(i)->c,
+			to.data(i)->c,
+			progress);
+		setData(i, {
+			uchar(color.red()),
+			uchar(color.green()),
+			uchar(color.blue()),
+			uchar(color.alpha()),
+		});
+	}
+}
+
+bool palette::colorChanged(int index) const {
+	return (index < 0)
+		|| (index < int(_changed.size()) && _changed[index]);
+}
+
+base::flat_set<int> palette::takeChangedColors() {
+	auto result = base::flat_set<int>();
+	for (auto i = 0, count = int(_changed.size()); i != count; ++i) {
+		if (_changed[i]) {
+			result.emplace(i);
+		}
+	}
+	_changed.clear();
+	return result;
+}
+
+void palette::markChangedFrom(const QByteArray &was) {
+	// save() of a palette that is not ready would finalize it without
+	// the colorizer, so without a snapshot on both sides mark everything.
+	if (!_ready || was.isEmpty()) {
+		_changed.assign(kCount, true);
+		return;
+	}
+	_changed.resize(kCount, false);
+	const auto now = save();
+	for (auto i = 0; i != kCount; ++i) {
+		if (memcmp(was.data() + i * 4, now.data() + i * 4, 4)) {
+			_changed[i] = true;
+		}
+	}
 }
 
 void palette::clear() {
@@ -180,9 +240,14 @@ void palette::compute(int index, int fallbackIndex, TempColorData value) {
 }
 
 void palette::setData(int index, const internal::ColorData &value) {
+	_changed.resize(kCount, false);
 	if (_status[index] == Status::Initial) {
 		new (data(index)) internal::ColorData(value);
+		_changed[index] = true;
 	} else {
+		if (data(index)->c != value.c) {
+			_changed[index] = true;
+		}
 		*data(index) = value;
 	}
 	_status[index] = Status::Loaded;
@@ -214,10 +279,24 @@ auto palette::PrepareFinalizeHelper(const colorizer &with)
 namespace main_palette {
 namespace {
 
+struct Transition {
+	palette from;
+	palette to;
+	Ui::Animations::Simple animation;
+};
+
+// Never destroyed on static teardown: Animations::Simple may not outlive
+// the animations manager, so the transition is deleted when finished.
+Transition *CurrentTransition = nullptr;
+
 palette &GetMutable() {
 	return const_cast<palette&>(*get());
 }
 
+void StopTransition() {
+	delete base::take(CurrentTransition);
+}
+
 } // namespace
 
 QByteArray save() {
@@ -225,6 +304,7 @@ QByteArray save() {
 }
 
 bool load(const QByteArray &cache) {
+	StopTransition();
 	if (GetMutable().load(cache)) {
 		style::internal::ResetIcons();
 		return true;
@@ -241,16 +321,54 @@ palette::SetResult setColor(QLatin1String name, QLatin1String from) {
 }
 
 void apply(const palette &other) {
+	StopTransition();
 	GetMutable() = other;
 	style::internal::ResetIcons();
 }
 
+void interpolate(const palette &from, const palette &to, float64 progress) {
+	GetMutable().interpolate(from, to, progress);
+	style::internal::RetintIcons();
+}
+
+void animateTo(const palette &to, crl::time duration) {
+	if (duration <= 0 || anim::Disabled()) {
+		apply(to);
+		NotifyPaletteChanged();
+		return;
+	}
+	StopTransition();
+	const auto raw = CurrentTransition = new Transition();
+	raw->from = *get();
+	raw->to = to;
+	raw->animation.start([=](float64 progress) {
+		interpolate(raw->from, raw->to, progress);
+		if (!raw->animation.animating()) {
+			// Return the icons to the shared pixmaps and drop the
+			// transition, but not from inside of its own animation callback.
+			style::internal::ResetIcons();
+			crl::on_main([=] {
+				if (CurrentTransition == raw && !raw->animation.animating()) {
+					StopTransition();
+				}
+			});
+		}
+		NotifyPaletteChanged();
+	}, 0., 1., duration);
+}
+
+bool animating() {
+	return CurrentTransition && CurrentTransition->animation.animating();
+}
+
 void reset() {
+	StopTransition();
 	GetMutable().reset();
 	style::internal::ResetIcons();
 }
 
 void reset(const colorizer &with) {
+	StopTransition();
 	GetMutable().reset(with);
 	style::internal::ResetIcons();
 }
@@ -259,5 +377,13 @@ int indexOfColor(color c) {
 	return GetMutable().indexOfColor(c);
 }
 
+bool colorChanged(int index) {
+	return get()->colorChanged(index);
+}
+
+base::flat_set<int> takeChangedColors() {
+	return GetMutable().takeChangedColors();
+}
+
 } // namespace main_palette
 } // namespace style
@@ -35,6 +35,12 @@ public:
 	void reset(const colorizer &with);
 	void reset();
 
+	// Sets each loaded color to the mix of 'from' and 'to' colors.
+	void interpolate(
+		const palette &from,
+		const palette &to,
+		float64 progress);
+
 	// Created not inited, should be finalized before usage.
 	void finalize(const colorizer &with);
 	void finalize();
@@ -42,6 +48,11 @@ public:
 	int indexOfColor(color c) const;
 	color colorAtIndex(int index) const;
 
+	// Indices of colors changed by load(), setColor(), reset() and
+	// assignment, accumulated until the next takeChangedColors() call.
+	[[nodiscard]] bool colorChanged(int index) const;
+	[[nodiscard]] base::flat_set<int> takeChangedColors();
+
 private:
 	struct FinalizeHelper;
 	struct TempColorData { uchar r, g, b, a; };
@@ -53,8 +64,10 @@ private:
 	void clear();
 	void compute(int index, int fallbackIndex, TempColorData value);
 	void setData(int index, const internal::ColorData &value);
+	void markChangedFrom(const QByteArray &was);
 
 	std::unique_ptr<FinalizeHelper> _finalizeHelper;
+	std::vector<bool> _changed;
 	bool _ready = false;
 
 };
@@ -67,9 +80,18 @@ bool load(const QByteArray &cache);
 palette::SetResult setColor(QLatin1String name, uchar r, uchar g, uchar b, uchar a);
 palette::SetResult setColor(QLatin1String name, QLatin1String from);
 void apply(const palette &other);
+void interpolate(const palette &from, const palette &to, float64 progress);
+
+// Moves the main palette to 'to' frame by frame, notifying about every
+// step, so that colorized caches are only tinted, not rebuilt from scratch.
+void animateTo(const palette &to, crl::time duration);
+[[nodiscard]] bool animating();
+
 void reset();
 void reset(const colorizer &with);
 int indexOfColor(color c);
+[[nodiscard]] bool colorChanged(int index);
+[[nodiscard]] base::flat_set<int> takeChangedColors();
 
 } // namespace main_palette
 } // namespace style
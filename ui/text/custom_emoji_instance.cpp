@@ -9,12 +9,17 @@
 #include "ui/effects/animation_value.h"
 #include "ui/effects/frame_generator.h"
 #include "ui/dynamic_image.h"
+#include "ui/main_queue_processor.h"
 #include "ui/ui_utility.h"
 #include "ui/painter.h"
 
 #include <crl/crl_async.h>
 #include <lz4.h>
 
+#include <QtCore/QThread>
+
+#include <deque>
+
 class QPainter;
 
 namespace Ui::CustomEmoji {
@@ -24,6 +29,46 @@ constexpr auto kMaxFrames = 180;
 constexpr auto kCacheVersion = 1;
 constexpr auto kPreloadFrames = 3;
 
+constexpr auto kMaxDefaultRenderWorkers = 4;
+
+UnloadStats Unloaded;
+
+struct RenderTask {
+	not_null<const Renderer*> renderer;
+	FnMut<FnMut<void()>()> work; // Returns the delivery for main.
+};
+
+class RenderScheduler final {
+public:
+	void push(
+		not_null<const Renderer*> renderer,
+		RenderPriority priority,
+		FnMut<FnMut<void()>()> work);
+	void cancel(not_null<const Renderer*> renderer);
+	void setLimit(int workers);
+	void firstFrame(crl::time duration);
+
+	[[nodiscard]] const RenderStats &stats() const;
+
+private:
+	void launch();
+	void finished();
+
+	std::array<std::deque<RenderTask>, kRenderPrioritiesCount> _queues;
+	RenderStats _stats;
+	int _limit = std::clamp(
+		QThread::idealThreadCount() - 1,
+		1,
+		kMaxDefaultRenderWorkers);
+
+};
+
+[[nodiscard]] RenderScheduler &Scheduler() {
+	// Renderers may be destroyed after the static objects, never free it.
+	static const auto result = new RenderScheduler();
+	return *result;
+}
+
 struct CacheHeader {
 	int version = 0;
 	int size = 0;
@@ -86,8 +131,105 @@ void PaintScaledImage(
 	}
 }
 
+void PaintScaledImage(
+		QPainter &p,
+		const QRect &target,
+		const Cache::Frame &frame,
+		const Context &context,
+		Text::CustomEmojiBatch *batch) {
+	if (batch && !context.scaled && !context.internal.colorized) {
+		batch->drawImage(p, target, frame.image, frame.source);
+	} else {
+		PaintScaledImage(p, target, frame, context);
+	}
+}
+
+void RenderScheduler::push(
+		not_null<const Renderer*> renderer,
+		RenderPriority priority,
+		FnMut<FnMut<void()>()> work) {
+	const auto index = int(priority);
+	_queues[index].push_back({ renderer, std::move(work) });
+	++_stats.queued[index];
+	auto queued = 0;
+	for (const auto count : _stats.queued) {
+		queued += count;
+	}
+	_stats.maxQueued = std::max(_stats.maxQueued, queued);
+	launch();
+}
+
+void RenderScheduler::cancel(not_null<const Renderer*> renderer) {
+	for (auto i = 0; i != kRenderPrioritiesCount; ++i) {
+		auto &queue = _queues[i];
+		const auto j = ranges::find(queue, renderer, &RenderTask::renderer);
+		if (j != end(queue)) {
+			queue.erase(j);
+			--_stats.queued[i];
+			++_stats.cancelled;
+		}
+	}
+}
+
+void RenderScheduler::setLimit(int workers) {
+	_limit = std::max(workers, 1);
+	launch();
+}
+
+void RenderScheduler::firstFrame(crl::time duration) {
+	++_stats.firstFrames;
+	_stats.firstFrameTotal += duration;
+	_stats.firstFrameMax = std::max(_stats.firstFrameMax, duration);
+}
+
+const RenderStats &RenderScheduler::stats() const {
+	return _stats;
+}
+
+void RenderScheduler::launch() {
+	for (auto i = 0; i != kRenderPrioritiesCount; ++i) {
+		auto &queue = _queues[i];
+		while (_stats.running < _limit && !queue.empty()) {
+			auto work = std::move(queue.front().work);
+			queue.pop_front();
+			--_stats.queued[i];
+			++_stats.running;
+			crl::async([work = std::move(work)]() mutable {
+				auto deliver = work();
+
+				// The slot is released together with the frame delivery,
+				// so the next frame of the same emoji may take it at once.
+				// Deliveries of many emoji are spread over the Paint lane
+				// slices instead of running in one main queue drain.
+				PostToMainQueue(MainQueueLane::Paint, [
+					deliver = std::move(deliver)
+				]() mutable {
+					if (deliver) {
+						deliver();
+					}
+					Scheduler().finished();
+				});
+			});
+		}
+	}
+}
+
+void RenderScheduler::finished() {
+	--_stats.running;
+	++_stats.rendered;
+	launch();
+}
+
 } // namespace
 
+void SetRenderWorkersLimit(int workers) {
+	Scheduler().setLimit(workers);
+}
+
+RenderStats RenderStatistics() {
+	return Scheduler().stats();
+}
+
 QColor PreviewColorFromTextColor(QColor color) {
 	color.setAlpha((color.alpha() + 1) / 8);
 	return color;
@@ -270,6 +412,14 @@ int Cache::size() const {
 	return _size;
 }
 
+int64 Cache::byteSize() const {
+	auto result = int64(_full.sizeInBytes());
+	for (const auto &image : _images) {
+		result += image.sizeInBytes();
+	}
+	return result;
+}
+
 Preview Cache::makePreview() const {
 	Expects(_frames > 0);
 
@@ -375,7 +525,8 @@ void Cache::finish() {
 
 PaintFrameResult Cache::paintCurrentFrame(
 		QPainter &p,
-		const Context &context) {
+		const Context &context,
+		Text::CustomEmojiBatch *batch) {
 	if (!_frames) {
 		return {};
 	}
@@ -405,7 +556,7 @@ PaintFrameResult Cache::paintCurrentFrame(
 	const auto info = frame(index);
 	const auto size = _size / style::DevicePixelRatio();
 	const auto rect = QRect(context.position, QSize(size, size));
-	PaintScaledImage(p, rect, info, context);
+	PaintScaledImage(p, rect, info, context, batch);
 	const auto next = first ? 0 : currentFrameFinishes();
 	return {
 		.painted = true,
@@ -440,8 +591,11 @@ QString Cached::entityData() const {
 	return _entityData;
 }
 
-PaintFrameResult Cached::paint(QPainter &p, const Context &context) {
-	return _cache.paintCurrentFrame(p, context);
+PaintFrameResult Cached::paint(
+		QPainter &p,
+		const Context &context,
+		Text::CustomEmojiBatch *batch) {
+	return _cache.paintCurrentFrame(p, context, batch);
 }
 
 bool Cached::inDefaultState() const {
@@ -452,6 +606,10 @@ Preview Cached::makePreview() const {
 	return _cache.makePreview();
 }
 
+int64 Cached::byteSize() const {
+	return _cache.byteSize();
+}
+
 Loading Cached::unload() {
 	return Loading(_unloader(), makePreview());
 }
@@ -459,34 +617,42 @@ Loading Cached::unload() {
 Renderer::Renderer(RendererDescriptor &&descriptor)
 : _cache(descriptor.size)
 , _put(std::move(descriptor.put))
-, _loader(std::move(descriptor.loader)) {
+, _loader(std::move(descriptor.loader))
+, _started(crl::now()) {
 	Expects(_loader != nullptr);
 
 	const auto size = _cache.size();
 	const auto guard = base::make_weak(this);
-	crl::async([=, factory = std::move(descriptor.generator)]() mutable {
+	Scheduler().push(this, RenderPriority::FirstFrame, [
+		=,
+		factory = std::move(descriptor.generator)
+	]() mutable -> FnMut<void()> {
 		auto generator = factory();
 		auto rendered = generator->renderNext(
 			QImage(),
 			QSize(size, size),
 			Qt::KeepAspectRatio);
 		if (rendered.image.isNull()) {
-			return;
+			return nullptr;
 		}
-		crl::on_main(guard, [
+		return [
 			=,
 			frame = std::move(rendered),
 			generator = std::move(generator)
 		]() mutable {
-			frameReady(
-				std::move(generator),
-				frame.duration,
-				std::move(frame.image));
-		});
+			if (const auto strong = guard.get()) {
+				strong->frameReady(
+					std::move(generator),
+					frame.duration,
+					std::move(frame.image));
+			}
+		};
 	});
 }
 
-Renderer::~Renderer() = default;
+Renderer::~Renderer() {
+	Scheduler().cancel(this);
+}
 
 void Renderer::frameReady(
 		std::unique_ptr<Ui::FrameGenerator> generator,
@@ -504,6 +670,9 @@ void Renderer::frameReady(
 	const auto current = _cache.currentFrame();
 	const auto total = _cache.frames();
 	const auto explicitRepaint = (current == total);
+	if (!total) {
+		Scheduler().firstFrame(crl::now() - _started);
+	}
 	_cache.add(duration, frame);
 	if (explicitRepaint && _repaint) {
 		_repaint();
@@ -511,7 +680,12 @@ void Renderer::frameReady(
 	if (!duration || total + 1 >= kMaxFrames) {
 		finish();
 	} else if (current + kPreloadFrames > total) {
-		renderNext(std::move(generator), std::move(frame));
+		renderNext(
+			std::move(generator),
+			std::move(frame),
+			(current == total
+				? RenderPriority::Visible
+				: RenderPriority::Preload));
 	} else {
 		_generator = std::move(generator);
 		_storage = std::move(frame);
@@ -520,28 +694,31 @@ void Renderer::frameReady(
 
 void Renderer::renderNext(
 		std::unique_ptr<Ui::FrameGenerator> generator,
-		QImage storage) {
+		QImage storage,
+		RenderPriority priority) {
 	const auto size = _cache.size();
 	const auto guard = base::make_weak(this);
-	crl::async([
+	Scheduler().push(this, priority, [
 		=,
 		storage = std::move(storage),
 		generator = std::move(generator)
-	]() mutable {
+	]() mutable -> FnMut<void()> {
 		auto rendered = generator->renderNext(
 			std::move(storage),
 			QSize(size, size),
 			Qt::KeepAspectRatio);
-		crl::on_main(guard, [
+		return [
 			=,
 			frame = std::move(rendered),
 			generator = std::move(generator)
 		]() mutable {
-			frameReady(
-				std::move(generator),
-				frame.duration,
-				std::move(frame.image));
-		});
+			if (const auto strong = guard.get()) {
+				strong->frameReady(
+					std::move(generator),
+					frame.duration,
+					std::move(frame.image));
+			}
+		};
 	});
 }
 
@@ -553,12 +730,20 @@ void Renderer::finish() {
 	}
 }
 
-PaintFrameResult Renderer::paint(QPainter &p, const Context &context) {
-	const auto result = _cache.paintCurrentFrame(p, context);
+PaintFrameResult Renderer::paint(
+		QPainter &p,
+		const Context &context,
+		Text::CustomEmojiBatch *batch) {
+	const auto result = _cache.paintCurrentFrame(p, context, batch);
 	if (_generator
 		&& (!result.painted
 			|| _cache.currentFrame() + kPreloadFrames >= _cache.frames())) {
-		renderNext(std::move(_generator), std::move(_storage));
+		renderNext(
+			std::move(_generator),
+			std::move(_storage),
+			(result.painted
+				? RenderPriority::Preload
+				: RenderPriority::Visible));
 	}
 	return result;
 }
@@ -652,6 +837,10 @@ void Loading::cancel() {
 	invalidate_weak_ptrs(this);
 }
 
+UnloadStats UnloadStatistics() {
+	return Unloaded;
+}
+
 Instance::Instance(
 	Loading loading,
 	Fn<void(not_null<Instance*>, RepaintRequest)> repaintLater)
@@ -670,32 +859,51 @@ QString Instance::entityData() const {
 }
 
 void Instance::paint(QPainter &p, const Context &context) {
+	const auto request = paintFrame(p, context, nullptr);
+	if (request.when) {
+		repaintLater(request);
+	}
+}
+
+RepaintRequest Instance::paintBatched(
+		QPainter &p,
+		const Context &context,
+		Text::CustomEmojiBatch &batch) {
+	return paintFrame(p, context, &batch);
+}
+
+RepaintRequest Instance::paintFrame(
+		QPainter &p,
+		const Context &context,
+		Text::CustomEmojiBatch *batch) {
 	context.internal.colorized = _colored;
 
+	auto request = RepaintRequest();
+	const auto check = [&](const PaintFrameResult &result) {
+		if (result.next > context.now) {
+			request = { result.next, result.duration };
+		}
+	};
 	v::match(_state, [&](Loading &state) {
 		state.paint(p, context);
 		load(state);
 	}, [&](Caching &state) {
-		auto result = state.renderer->paint(p, context);
+		auto result = state.renderer->paint(p, context, batch);
 		if (!result.painted) {
 			state.preview.paint(p, context);
 		} else {
 			if (!state.preview.isExactImage()) {
 				state.preview = state.renderer->makePreview();
 			}
-			if (result.next > context.now) {
-				_repaintLater(this, { result.next, result.duration });
-			}
+			check(result);
 		}
 		if (auto cached = state.renderer->ready(state.entityData)) {
 			_state = std::move(*cached);
 		}
 	}, [&](Cached &state) {
-		const auto result = state.paint(p, context);
-		if (result.next > context.now) {
-			_repaintLater(this, { result.next, result.duration });
-		}
+		check(state.paint(p, context, batch));
 	});
+	return request;
 }
 
 bool Instance::ready() {
@@ -777,12 +985,24 @@ void Instance::setColored() {
 	if (!_colored) {
 		_colored = true;
 		if (ready()) {
-			_repaintLater(this, { .when = crl::now() + 1 });
+			repaintLater({ .when = crl::now() + 1 });
 		}
 	}
 }
 
+void Instance::repaintLater(RepaintRequest request) {
+	// All objects of this instance painted in one frame request the
+	// same repaint, pass it only once. Instances painted in one text
+	// are already reduced to a single request by Text::CustomEmojiBatch.
+	if (request.when && request.when == _repaintRequested) {
+		return;
+	}
+	_repaintRequested = request.when;
+	_repaintLater(this, request);
+}
+
 void Instance::repaint() {
+	_repaintRequested = 0;
 	for (const auto &object : _usage) {
 		object->repaint();
 	}
@@ -805,9 +1025,11 @@ void Instance::decrementUsage(not_null<Object*> object) {
 			std::move(state.preview),
 		};
 	}, [&](Cached &state) {
+		++Unloaded.unloads;
+		Unloaded.bytesReleased += state.byteSize();
 		_state = state.unload();
 	});
-	_repaintLater(this, RepaintRequest());
+	repaintLater(RepaintRequest());
 }
 
 Object::Object(not_null<Instance*> instance, Fn<void()> repaint)
@@ -835,6 +1057,24 @@ void Object::paint(QPainter &p, const Context &context) {
 	_instance->paint(p, context);
 }
 
+void Object::paintBatched(
+		QPainter &p,
+		const Context &context,
+		Text::CustomEmojiBatch &batch) {
+	if (!_using) {
+		_using = true;
+		_instance->incrementUsage(this);
+	}
+	const auto request = _instance->paintBatched(p, context, batch);
+	if (request.when) {
+		batch.repaintLater(this, request.when, request.duration);
+	}
+}
+
+void Object::repaintLater(crl::time when, crl::time duration) {
+	_instance->repaintLater({ when, duration });
+}
+
 void Object::unload() {
 	if (_using) {
 		_using = false;
@@ -886,13 +1126,27 @@ QString Internal::entityData() {
 }
 
 void Internal::paint(QPainter &p, const Context &context) {
+	paintImage(p, context, nullptr);
+}
+
+void Internal::paintBatched(
+		QPainter &p,
+		const Context &context,
+		Text::CustomEmojiBatch &batch) {
+	paintImage(p, context, &batch);
+}
+
+void Internal::paintImage(
+		QPainter &p,
+		const Context &context,
+		Text::CustomEmojiBatch *batch) {
 	context.internal.colorized = _colored;
 
 	const auto size = _image.size() / style::DevicePixelRatio();
 	const auto rect = QRect(
 		context.position + QPoint(_padding.left(), _padding.top()),
 		size);
-	PaintScaledImage(p, rect, { &_image }, context);
+	PaintScaledImage(p, rect, { &_image }, context, batch);
 }
 
 void Internal::unload() {
@@ -89,13 +89,18 @@ public:
 	[[nodiscard]] int frames() const;
 	[[nodiscard]] bool readyInDefaultState() const;
 	[[nodiscard]] Frame frame(int index) const;
+	[[nodiscard]] int64 byteSize() const;
 	void reserve(int frames);
 	void add(crl::time duration, const QImage &frame);
 	void finish();
 
 	[[nodiscard]] Preview makePreview() const;
 
-	PaintFrameResult paintCurrentFrame(QPainter &p, const Context &context);
+	// With a 'batch' the frame blit is deferred to the batch.
+	PaintFrameResult paintCurrentFrame(
+		QPainter &p,
+		const Context &context,
+		Text::CustomEmojiBatch *batch = nullptr);
 	[[nodiscard]] int currentFrame() const;
 
 private:
@@ -128,8 +133,12 @@ public:
 
 	[[nodiscard]] QString entityData() const;
 	[[nodiscard]] Preview makePreview() const;
-	PaintFrameResult paint(QPainter &p, const Context &context);
+	PaintFrameResult paint(
+		QPainter &p,
+		const Context &context,
+		Text::CustomEmojiBatch *batch = nullptr);
 	[[nodiscard]] bool inDefaultState() const;
+	[[nodiscard]] int64 byteSize() const;
 	[[nodiscard]] Loading unload();
 
 private:
@@ -139,6 +148,29 @@ private:
 
 };
 
+// Frames of all the renderers are prepared by a limited number of
+// background tasks, first frames go first, then the ones being painted.
+enum class RenderPriority {
+	FirstFrame,
+	Visible,
+	Preload,
+};
+inline constexpr auto kRenderPrioritiesCount = 3;
+
+void SetRenderWorkersLimit(int workers);
+
+struct RenderStats {
+	std::array<int, kRenderPrioritiesCount> queued = {};
+	int running = 0;
+	int maxQueued = 0;
+	int64 rendered = 0;
+	int64 cancelled = 0;
+	int64 firstFrames = 0;
+	crl::time firstFrameTotal = 0;
+	crl::time firstFrameMax = 0;
+};
+[[nodiscard]] RenderStats RenderStatistics();
+
 struct RendererDescriptor {
 	Fn<std::unique_ptr<Ui::FrameGenerator>()> generator;
 	Fn<void(QByteArray)> put;
@@ -151,7 +183,10 @@ public:
 	explicit Renderer(RendererDescriptor &&descriptor);
 	virtual ~Renderer();
 
-	PaintFrameResult paint(QPainter &p, const Context &context);
+	PaintFrameResult paint(
+		QPainter &p,
+		const Context &context,
+		Text::CustomEmojiBatch *batch = nullptr);
 	[[nodiscard]] std::optional<Cached> ready(const QString &entityData);
 	[[nodiscard]] std::unique_ptr<Loader> cancel();
 
@@ -169,7 +204,8 @@ private:
 		QImage frame);
 	void renderNext(
 		std::unique_ptr<Ui::FrameGenerator> generator,
-		QImage storage);
+		QImage storage,
+		RenderPriority priority);
 	void finish();
 
 	Cache _cache;
@@ -178,6 +214,7 @@ private:
 	Fn<void(QByteArray)> _put;
 	Fn<void()> _repaint;
 	Fn<std::unique_ptr<Loader>()> _loader;
+	crl::time _started = 0;
 	bool _finished = false;
 
 };
@@ -224,6 +261,12 @@ struct RepaintRequest {
 	crl::time duration = 0;
 };
 
+struct UnloadStats {
+	int64 unloads = 0;
+	int64 bytesReleased = 0;
+};
+[[nodiscard]] UnloadStats UnloadStatistics();
+
 class Object;
 class Instance final : public base::has_weak_ptr {
 public:
@@ -235,6 +278,12 @@ public:
 
 	[[nodiscard]] QString entityData() const;
 	void paint(QPainter &p, const Context &context);
+
+	// Returns the next frame repaint instead of requesting it.
+	[[nodiscard]] RepaintRequest paintBatched(
+		QPainter &p,
+		const Context &context,
+		Text::CustomEmojiBatch &batch);
 	[[nodiscard]] bool ready();
 	[[nodiscard]] bool readyInDefaultState();
 	[[nodiscard]] bool hasImagePreview() const;
@@ -246,13 +295,19 @@ public:
 	void decrementUsage(not_null<Object*> object);
 
 	void repaint();
+	void repaintLater(RepaintRequest request);
 
 private:
 	void load(Loading &state);
+	[[nodiscard]] RepaintRequest paintFrame(
+		QPainter &p,
+		const Context &context,
+		Text::CustomEmojiBatch *batch);
 
 	std::variant<Loading, Caching, Cached> _state;
 	base::flat_set<not_null<Object*>> _usage;
 	Fn<void(not_null<Instance*> that, RepaintRequest)> _repaintLater;
+	crl::time _repaintRequested = 0;
 	bool _colored = false;
 
 };
@@ -268,6 +323,11 @@ public:
 	void unload() override;
 	bool ready() override;
 	bool readyInDefaultState() override;
+	void paintBatched(
+		QPainter &p,
+		const Context &context,
+		Text::CustomEmojiBatch &batch) override;
+	void repaintLater(crl::time when, crl::time duration) override;
 
 	void repaint();
 
@@ -292,8 +352,17 @@ public:
 	void unload() override;
 	bool ready() override;
 	bool readyInDefaultState() override;
+	void paintBatched(
+		QPainter &p,
+		const Context &context,
+		Text::CustomEmojiBatch &batch) override;
 
 private:
+	void paintImage(
+		QPainter &p,
+		const Context &context,
+		Text::CustomEmojiBatch *batch);
+
 	const QString _entityData;
 	const QImage _image;
 	const QMargins _padding;
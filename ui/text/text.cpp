@@ -7,6 +7,7 @@
 #include "ui/text/text.h"
 
 #include "ui/effects/spoiler_mess.h"
+#include "ui/style/style_core_palette.h"
 #include "ui/text/text_block_parser.h"
 #include "ui/text/text_extended_data.h"
 #include "ui/text/text_isolated_emoji.h"
@@ -16,6 +17,7 @@
 #include "ui/basic_click_handlers.h"
 #include "ui/integration.h"
 #include "ui/painter.h"
+#include "ui/ui_trace.h"
 #include "base/platform/base_platform_info.h"
 #include "styles/style_basic.h"
 
@@ -32,6 +34,219 @@ namespace Ui::Text {
 namespace {
 
 constexpr auto kDefaultSpoilerCacheCapacity = 24;
+constexpr auto kHitTestIndexMinLength = 128;
+constexpr auto kBalancedWidthMaxPasses = 16;
+constexpr auto kMaxQuoteAtlasEntries = 64;
+
+using IconShape = std::vector<style::internal::IconShapePart>;
+
+// Everything of the style the images depend on, the style itself
+// may be destroyed and another one created at the same address.
+struct QuoteImagesKey {
+	IconShape icon;
+	IconShape expand;
+	IconShape collapse;
+	int iconLeft = 0;
+	int iconTop = 0;
+	int radius = 0;
+	int header = 0;
+	int outline = 0;
+	int outlineShift = 0;
+	std::array<QRgb, kMaxQuoteOutlines> outlines = {};
+	QRgb headerColor = 0;
+	QRgb bg = 0;
+	QRgb icon = 0;
+
+	friend inline std::strong_ordering operator<=>(
+		const QuoteImagesKey &a,
+		const QuoteImagesKey &b) = default;
+	friend inline bool operator==(
+		const QuoteImagesKey &a,
+		const QuoteImagesKey &b) = default;
+};
+
+struct QuoteImages {
+	QImage corners;
+	QImage outline;
+	QImage expand;
+	QImage collapse;
+	uint64 used = 0;
+};
+
+// All quote paint caches with the same style and colors share the images.
+struct QuoteAtlas {
+	base::flat_map<QuoteImagesKey, QuoteImages> entries;
+	uint64 counter = 0;
+	int scale = 0;
+	int ratio = 0;
+};
+
+QuoteAtlas QuotesAtlas;
+
+[[nodiscard]] const QuoteImages *LookupQuoteImages(
+		const QuoteImagesKey &key) {
+	// The images depend on the palette only through the key colors,
+	// so a palette change leaves the entries valid.
+	const auto scale = style::Scale();
+	const auto ratio = style::DevicePixelRatio();
+	if (QuotesAtlas.scale != scale || QuotesAtlas.ratio != ratio) {
+		QuotesAtlas.entries.clear();
+		QuotesAtlas.scale = scale;
+		QuotesAtlas.ratio = ratio;
+	}
+	const auto i = QuotesAtlas.entries.find(key);
+	if (i == end(QuotesAtlas.entries)) {
+		return nullptr;
+	}
+	i->second.used = ++QuotesAtlas.counter;
+	return &i->second;
+}
+
+void RememberQuoteImages(
+		const QuoteImagesKey &key,
+		const QuotePaintCache &cache) {
+	auto &entries = QuotesAtlas.entries;
+	if (int(entries.size()) >= kMaxQuoteAtlasEntries) {
+		entries.erase(ranges::min_element(
+			entries,
+			ranges::less(),
+			[](const auto &pair) { return pair.second.used; }));
+	}
+	entries.emplace(key, QuoteImages{
+		.corners = cache.corners,
+		.outline = cache.outline,
+		.expand = cache.expand,
+		.collapse = cache.collapse,
+		.used = ++QuotesAtlas.counter,
+	});
+}
+
+// The word breaking of String::enumerateLines(), shared with the balanced
+// width search, so that both of them always break the lines the same way.
+//
+// 'newline(w, widthLeft)' ends the line at a newline word,
+// 'hidden()' tells that the words are not laid out (quote lines limit),
+// 'rewind()' tells that the word that didn't fit may go to the next line,
+// 'wrap(widthLeft, deficit)' ends the line at a word that didn't fit.
+// Both 'newline' and 'wrap' return the width of the next line, or
+// std::nullopt to stop, and then BreakWords() returns std::nullopt too.
+// Otherwise it returns the width left in the last line.
+template <
+	typename Newline,
+	typename Hidden,
+	typename Rewind,
+	typename Wrap>
+[[nodiscard]] std::optional<QFixed> BreakWords(
+		const Words &words,
+		QFixed widthLeft,
+		bool breakEverywhere,
+		Newline &&newline,
+		Hidden &&hidden,
+		Rewind &&rewind,
+		Wrap &&wrap) {
+	auto last_rBearing = QFixed();
+	auto last_rPadding = QFixed();
+	auto longWordLine = true;
+	auto lastWordStart = begin(words);
+	auto lastWordStart_wLeft = widthLeft;
+	for (auto w = lastWordStart, e = end(words); w != e; ++w) {
+		if (w->newline()) {
+			const auto next = newline(w, widthLeft);
+			if (!next) {
+				return std::nullopt;
+			}
+			widthLeft = *next;
+
+			last_rBearing = 0;// b->f_rbearing(); (0 for newline)
+			last_rPadding = w->f_rpadding();
+
+			longWordLine = true;
+			lastWordStart = w;
+			lastWordStart_wLeft = widthLeft;
+			continue;
+		} else if (hidden()) {
+			continue;
+		}
+		const auto wordEndsHere = !w->unfinished();
+
+		auto w__f_width = w->f_width();
+		const auto w__f_rbearing = w->f_rbearing();
+		const auto newWidthLeft = widthLeft
+			- last_rBearing
+			- (last_rPadding + w__f_width - w__f_rbearing);
+		if (newWidthLeft >= 0) {
+			last_rBearing = w__f_rbearing;
+			last_rPadding = w->f_rpadding();
+			widthLeft = newWidthLeft;
+
+			if (wordEndsHere) {
+				longWordLine = false;
+			}
+			if (wordEndsHere || longWordLine) {
+				lastWordStart_wLeft = widthLeft;
+				lastWordStart = w + 1;
+			}
+			continue;
+		}
+
+		if (w != lastWordStart && !breakEverywhere && rewind()) {
+			w = lastWordStart;
+			widthLeft = lastWordStart_wLeft;
+			w__f_width = w->f_width();
+		}
+		const auto next = wrap(widthLeft, -newWidthLeft);
+		if (!next) {
+			return std::nullopt;
+		}
+		widthLeft = *next;
+
+		last_rBearing = w->f_rbearing();
+		last_rPadding = w->f_rpadding();
+		widthLeft -= w__f_width - last_rBearing;
+
+		longWordLine = !wordEndsHere;
+		lastWordStart = w + 1;
+		lastWordStart_wLeft = widthLeft;
+	}
+	return widthLeft;
+}
+
+struct BreakPass {
+	int lines = 0;
+	QFixed deficit; // Smallest widening that changes any line break.
+};
+
+// Line count of String::enumerateLines() for texts without quotes.
+[[nodiscard]] BreakPass CountBreakPass(
+		const Words &words,
+		bool startsWithNewline,
+		QFixed width,
+		bool breakEverywhere) {
+	auto result = BreakPass();
+	auto lineWidth = startsWithNewline ? QFixed() : width;
+	const auto nextLine = [&] {
+		++result.lines;
+		lineWidth = width;
+		return std::make_optional(width);
+	};
+	const auto widthLeft = BreakWords(
+		words,
+		lineWidth,
+		breakEverywhere,
+		[&](Words::const_iterator, QFixed) { return nextLine(); },
+		[] { return false; },
+		[] { return true; },
+		[&](QFixed, QFixed deficit) {
+			if (!result.deficit || deficit < result.deficit) {
+				result.deficit = deficit;
+			}
+			return nextLine();
+		});
+	if (*widthLeft < lineWidth) {
+		++result.lines;
+	}
+	return result;
+}
 
 [[nodiscard]] Qt::LayoutDirection StringDirection(
 		const QString &str,
@@ -101,6 +316,7 @@ namespace Ui::Text {
 struct SpoilerMessCache::Entry {
 	SpoilerMessCached mess;
 	QColor color;
+	int paletteIndex = -1;
 };
 
 SpoilerMessCache::SpoilerMessCache(int capacity) : _capacity(capacity) {
@@ -125,15 +341,37 @@ not_null<SpoilerMessCached*> SpoilerMessCache::lookup(QColor color) {
 	return &_cache.back().mess;
 }
 
+not_null<SpoilerMessCached*> SpoilerMessCache::lookup(
+		const style::color &color) {
+	const auto index = style::main_palette::indexOfColor(color);
+	for (auto &entry : _cache) {
+		if (entry.color == color->c) {
+			if (entry.paletteIndex < 0) {
+				entry.paletteIndex = index;
+			}
+			return &entry.mess;
+		}
+	}
+	const auto result = lookup(color->c);
+	_cache.back().paletteIndex = index;
+	return result;
+}
+
 void SpoilerMessCache::reset() {
 	_cache.clear();
 }
 
+void SpoilerMessCache::resetChanged() {
+	_cache.erase(ranges::remove_if(_cache, [](const Entry &entry) {
+		return style::PaletteColorChanged(entry.paletteIndex);
+	}), end(_cache));
+}
+
 not_null<SpoilerMessCache*> DefaultSpoilerCache() {
 	struct Data {
 		Data() : cache(kDefaultSpoilerCacheCapacity) {
 			style::PaletteChanged() | rpl::on_next([=] {
-				cache.reset();
+				cache.resetChanged();
 			}, lifetime);
 		}
 
@@ -186,9 +424,11 @@ void ValidateQuotePaintCache(
 	const auto icon = st.icon.empty() ? nullptr : &st.icon;
 	const auto expand = st.expand.empty() ? nullptr : &st.expand;
 	const auto collapse = st.collapse.empty() ? nullptr : &st.collapse;
+	const auto ratio = style::DevicePixelRatio();
 	if (!cache.corners.isNull()
+		&& cache.corners.devicePixelRatio() == ratio
 		&& cache.bgCached == cache.bg
-		&& cache.outlines == cache.outlines
+		&& cache.outlinesCached == cache.outlines
 		&& (!st.header || cache.headerCached == cache.header)
 		&& ((!icon && !expand && !collapse)
 			|| cache.iconCached == cache.icon)) {
@@ -202,6 +442,30 @@ void ValidateQuotePaintCache(
 	if (icon || expand || collapse) {
 		cache.iconCached = cache.icon;
 	}
+	auto key = QuoteImagesKey{
+		.icon = icon ? icon->shape() : IconShape(),
+		.expand = expand ? expand->shape() : IconShape(),
+		.collapse = collapse ? collapse->shape() : IconShape(),
+		.iconLeft = icon ? st.iconPosition.x() : 0,
+		.iconTop = icon ? st.iconPosition.y() : 0,
+		.radius = st.radius,
+		.header = st.header,
+		.outline = st.outline,
+		.outlineShift = st.outlineShift,
+		.headerColor = st.header ? cache.header.rgba() : QRgb(),
+		.bg = cache.bg.rgba(),
+		.icon = (icon || expand || collapse) ? cache.icon.rgba() : QRgb(),
+	};
+	for (auto i = 0; i != kMaxQuoteOutlines; ++i) {
+		key.outlines[i] = cache.outlines[i].rgba();
+	}
+	if (const auto images = LookupQuoteImages(key)) {
+		cache.corners = images->corners;
+		cache.outline = images->outline;
+		cache.expand = images->expand;
+		cache.collapse = images->collapse;
+		return;
+	}
 	const auto radius = st.radius;
 	const auto header = st.header;
 	const auto outline = st.outline;
@@ -217,7 +481,6 @@ void ValidateQuotePaintCache(
 	const auto wside = 2 * wcorner + middle;
 	const auto hside = 2 * hcorner + middle;
 	const auto full = QSize(wside, hside);
-	const auto ratio = style::DevicePixelRatio();
 
 	if (!cache.outlines[1].alpha()) {
 		cache.outline = QImage();
@@ -291,6 +554,7 @@ void ValidateQuotePaintCache(
 	cache.corners = std::move(image);
 	cache.expand = expand ? expand->instance(cache.icon) : QImage();
 	cache.collapse = collapse ? collapse->instance(cache.icon) : QImage();
+	RememberQuoteImages(key, cache);
 }
 
 void FillQuotePaint(
@@ -370,7 +634,7 @@ void FillQuotePaint(
 				cache.bg);
 		}
 		if (skip) {
-			if (cache.bottomCorner.size() != QSize(skip, whalf)) {
+			if (cache.bottomRounding.size() != QSize(skip, hhalf) * ratio) {
 				cache.bottomCorner = QImage(
 					QSize(skip, hhalf) * ratio,
 					QImage::Format_ARGB32_Premultiplied);
@@ -400,6 +664,7 @@ void FillQuotePaint(
 				+ (parts.skippedTop ? int(parts.skippedTop) : hhalf)
 				- st.outlineShift;
 			q.translate(0, -skipped);
+			q.setCompositionMode(QPainter::CompositionMode_Source);
 			q.fillRect(0, skipped, skip, bottom, cache.outline);
 			q.setCompositionMode(QPainter::CompositionMode_DestinationIn);
 			q.drawImage(0, skipped + bottom - hhalf, cache.bottomRounding);
@@ -542,6 +807,9 @@ void String::setText(const style::TextStyle &st, const QString &text, const Text
 void String::recountNaturalSize(
 		bool initial,
 		Qt::LayoutDirection optionsDirection) {
+	_hitTestIndex = nullptr;
+	_balancedWidth = BalancedWidth();
+
 	auto lastNewlineBlock = begin(_blocks);
 	auto lastNewlineStart = 0;
 	const auto computeParagraphDirection = [&](int paragraphEnd) {
@@ -725,9 +993,11 @@ void String::setMarkedText(
 //		newText.append("},\n\n").append(text);
 //		BlockParser block(this, { newText, EntitiesInText() }, options, context);
 
+		UI_TRACE_SCOPE("Text::parse");
 		BlockParser block(this, textWithEntities, options, context);
 		WordParser word(this);
 	}
+	UI_TRACE_SCOPE("Text::layout");
 	recountNaturalSize(true, options.dir);
 }
 
@@ -1001,6 +1271,100 @@ int String::countHeight(int width, bool breakEverywhere) const {
 	return result;
 }
 
+int String::countBalancedWidth(
+		int minWidth,
+		int maxWidth,
+		bool breakEverywhere) const {
+	if (isEmpty() || minWidth >= maxWidth) {
+		return maxWidth;
+	}
+	auto &cache = _balancedWidth;
+	if (cache.minWidth != minWidth
+		|| cache.maxWidth != maxWidth
+		|| cache.breakEverywhere != breakEverywhere) {
+		cache = BalancedWidth{
+			.minWidth = minWidth,
+			.maxWidth = maxWidth,
+			.result = countBalancedWidthUncached(
+				minWidth,
+				maxWidth,
+				breakEverywhere),
+			.breakEverywhere = breakEverywhere,
+		};
+	}
+	return cache.result;
+}
+
+int String::countBalancedWidthUncached(
+		int minWidth,
+		int maxWidth,
+		bool breakEverywhere) const {
+	const auto heightForWidth = [&](int width) {
+		return countHeight(width, breakEverywhere);
+	};
+	if (_extended && _extended->quotes) {
+		// Quote paddings and line limits are not known to the word pass.
+		return FindNiceTooltipWidth(minWidth, maxWidth, heightForWidth);
+	}
+	const auto startsWithNewline
+		= ((*_blocks.cbegin())->type() == TextBlockType::Newline);
+	const auto pass = [&](int width) {
+		return CountBreakPass(
+			_words,
+			startsWithNewline,
+			std::max(width, _minResizeWidth),
+			breakEverywhere);
+	};
+	const auto target = pass(maxWidth).lines;
+	if (target <= 0) {
+		return maxWidth;
+	}
+
+	// Each line holds at most 'width' of the words, so start
+	// from the total words width evenly split between the lines.
+	auto total = QFixed();
+	auto bearing = QFixed();
+	for (const auto &word : _words) {
+		total += word.f_width();
+		bearing = std::max(bearing, word.f_rbearing());
+	}
+	auto width = std::clamp(
+		(total / target - bearing).floor().toInt(),
+		minWidth,
+		maxWidth);
+
+	// Between the break deficits the layout stays the same,
+	// so jumping by the smallest of them never skips the answer.
+	// That takes up to kBalancedWidthMaxPasses word passes,
+	// then it falls back to the countHeight() search.
+	auto found = false;
+	for (auto i = 0; i != kBalancedWidthMaxPasses; ++i) {
+		if (width >= maxWidth) {
+			return maxWidth;
+		}
+		const auto current = pass(width);
+		if (current.lines <= target) {
+			found = true;
+			break;
+		}
+		const auto effective = std::max(width, _minResizeWidth);
+		width = effective + std::max(current.deficit.ceil().toInt(), 1);
+	}
+	if (!found) {
+		return FindNiceTooltipWidth(
+			std::min(width, maxWidth),
+			maxWidth,
+			heightForWidth);
+	} else if (_blocks.back()->type() == TextBlockType::Skip) {
+		// The last line height may depend on the skip block.
+		const auto desired = heightForWidth(maxWidth);
+		if (heightForWidth(width) > desired) {
+			return FindNiceTooltipWidth(width, maxWidth, heightForWidth);
+		}
+	}
+	return width;
+}
+
 std::vector<int> String::countLineWidths(int width) const {
 	return countLineWidths(width, {});
 }
@@ -1085,89 +1449,54 @@ void String::enumerateLines(
 	}
 
 	const auto lineHeight = this->lineHeight();
-	auto last_rBearing = QFixed();
-	auto last_rPadding = QFixed();
-	auto longWordLine = true;
-	auto lastWordStart = begin(_words);
-	auto lastWordStart_wLeft = widthLeft;
-	for (auto w = lastWordStart, e = end(_words); w != e; ++w) {
-		if (w->newline()) {
-			const auto block = w->newlineBlockIndex();
-			const auto index = quoteIndex(_blocks[block].get());
-			const auto hidden = !qlinesleft;
-			const auto changed = (qindex != index);
-			if (changed) {
-				top += qpadding.bottom();
-			}
-
-			if (qlinesleft > 0) {
-				--qlinesleft;
-			}
-			if (!hidden) {
-				callback(lineLeft + lineWidth - widthLeft, top += lineHeight);
-			}
-			if (lineElided) {
-				return withElided(true);
-			}
-
-			last_rBearing = 0;// b->f_rbearing(); (0 for newline)
-			last_rPadding = w->f_rpadding();
-
-			initNextParagraph(index);
-			longWordLine = true;
-			lastWordStart = w;
-			lastWordStart_wLeft = widthLeft;
-			continue;
-		} else if (!qlinesleft) {
-			continue;
+	const auto newline = [&](
+			Words::const_iterator w,
+			QFixed lastWidthLeft) -> std::optional<QFixed> {
+		const auto block = w->newlineBlockIndex();
+		const auto index = quoteIndex(_blocks[block].get());
+		const auto hidden = !qlinesleft;
+		const auto changed = (qindex != index);
+		if (changed) {
+			top += qpadding.bottom();
 		}
-		const auto wordEndsHere = !w->unfinished();
-
-		auto w__f_width = w->f_width();
-		const auto w__f_rbearing = w->f_rbearing();
-		const auto newWidthLeft = widthLeft
-			- last_rBearing
-			- (last_rPadding + w__f_width - w__f_rbearing);
-		if (newWidthLeft >= 0) {
-			last_rBearing = w__f_rbearing;
-			last_rPadding = w->f_rpadding();
-			widthLeft = newWidthLeft;
 
-			if (wordEndsHere) {
-				longWordLine = false;
-			}
-			if (wordEndsHere || longWordLine) {
-				lastWordStart_wLeft = widthLeft;
-				lastWordStart = w + 1;
-			}
-			continue;
+		if (qlinesleft > 0) {
+			--qlinesleft;
+		}
+		if (!hidden) {
+			callback(lineLeft + lineWidth - lastWidthLeft, top += lineHeight);
 		}
-
 		if (lineElided) {
-		} else if (w != lastWordStart && !geometry.breakEverywhere) {
-			w = lastWordStart;
-			widthLeft = lastWordStart_wLeft;
-			w__f_width = w->f_width();
+			return std::nullopt;
 		}
-
+		initNextParagraph(index);
+		return widthLeft;
+	};
+	const auto wrap = [&](
+			QFixed lastWidthLeft,
+			QFixed) -> std::optional<QFixed> {
 		if (qlinesleft > 0) {
 			--qlinesleft;
 		}
-		callback(lineLeft + lineWidth - widthLeft, top += lineHeight);
+		callback(lineLeft + lineWidth - lastWidthLeft, top += lineHeight);
 		if (lineElided) {
-			return withElided(true);
+			return std::nullopt;
 		}
-
 		initNextLine();
-
-		last_rBearing = w->f_rbearing();
-		last_rPadding = w->f_rpadding();
-		widthLeft -= w__f_width - last_rBearing;
-
-		longWordLine = !wordEndsHere;
-		lastWordStart = w + 1;
-		lastWordStart_wLeft = widthLeft;
-	}
+		return widthLeft;
+	};
+	const auto last = BreakWords(
+		_words,
+		widthLeft,
+		geometry.breakEverywhere,
+		newline,
+		[&] { return !qlinesleft; },
+		[&] { return !lineElided; },
+		wrap);
+	if (!last) {
+		return withElided(true);
+	}
+	widthLeft = *last;
 	if (widthLeft < lineWidth) {
 		const auto useSkipHeight = (_blocks.back()->type() == TextBlockType::Skip)
 			&& (widthLeft + _words.back().f_width() == lineWidth);
@@ -1255,6 +1584,8 @@ void String::drawRightElided(Painter &p, int32 right, int32 top, int32 width, in
 StateResult String::getState(QPoint point, int width, StateRequest request) const {
 	if (isEmpty()) {
 		return {};
+	} else if (const auto index = hitTestIndex(width, request.align)) {
+		return Renderer(*this).getState(point, *index, request);
 	}
 	return Renderer(*this).getState(
 		point,
@@ -1262,6 +1593,75 @@ StateResult String::getState(QPoint point, int width, StateRequest request) cons
 		request);
 }
 
+const HitTestIndex *String::hitTestIndex(
+		int width,
+		style::align align) const {
+	// Short texts are cheap to lay out.
+	if (_text.size() < kHitTestIndexMinLength) {
+		return nullptr;
+	}
+	const auto rtl = style::RightToLeft();
+	if (!_hitTestIndex
+		|| _hitTestIndex->width != width
+		|| _hitTestIndex->align != align
+		|| _hitTestIndex->rtl != rtl) {
+		// Build only when the same width is looked up more than once.
+		_hitTestIndex = std::make_unique<HitTestIndex>();
+		_hitTestIndex->width = width;
+		_hitTestIndex->align = align;
+		_hitTestIndex->rtl = rtl;
+		return nullptr;
+	} else if (!_hitTestIndex->built) {
+		Renderer(*this).buildHitTestIndex(
+			*_hitTestIndex,
+			SimpleGeometry(width, 0, 0, false));
+		indexParagraphs(*_hitTestIndex);
+	}
+	return _hitTestIndex.get();
+}
+
+void String::indexParagraphs(HitTestIndex &index) const {
+	index.paragraphs.clear();
+	index.monos.clear();
+	for (auto i = 0, size = int(_text.size()); i != size; ++i) {
+		if (IsParagraphSeparator(_text[i])) {
+			index.paragraphs.push_back(uint16(i));
+		}
+	}
+
+	// Same ranges as the Pre and Code entities in toText().
+	const auto mono = [](TextBlockFlags flags) {
+		return flags & (TextBlockFlag::Pre | TextBlockFlag::Code);
+	};
+	auto flags = TextBlockFlags();
+	auto quoteIndex = int(_startQuoteIndex);
+	auto start = uint16(0);
+	for (auto i = begin(_blocks), e = end(_blocks); true; ++i) {
+		const auto position = (i == e)
+			? uint16(_text.size())
+			: (*i)->position();
+		const auto blockFlags = (i == e) ? TextBlockFlags() : (*i)->flags();
+		const auto blockQuoteIndex = (i == e)
+			? 0
+			: ((*i)->type() != TextBlockType::Newline)
+			? quoteIndex
+			: static_cast<const NewlineBlock*>(i->get())->quoteIndex();
+		if (mono(blockFlags) != mono(flags)
+			|| ((flags & TextBlockFlag::Pre)
+				&& blockQuoteIndex != quoteIndex)) {
+			if (mono(flags) && position > start) {
+				index.monos.push_back({ start, position });
+			}
+			start = position;
+			flags = blockFlags;
+		}
+		quoteIndex = blockQuoteIndex;
+		if (i == e) {
+			break;
+		}
+	}
+}
+
 StateResult String::getStateLeft(QPoint point, int width, int outerw, StateRequest request) const {
 	return getState(style::rtlpoint(point, outerw), width, request);
 }
@@ -1286,7 +1686,12 @@ TextSelection String::adjustSelection(TextSelection selection, TextSelectType se
 	uint16 from = selection.from, to = selection.to;
 	if (from < _text.size() && from <= to) {
 		if (to > _text.size()) to = _text.size();
-		if (selectType == TextSelectType::Paragraphs) {
+		const auto index = (_hitTestIndex && _hitTestIndex->built)
+			? _hitTestIndex.get()
+			: nullptr;
+		if (selectType == TextSelectType::Paragraphs && index) {
+			return adjustParagraphSelection(*index, from, to);
+		} else if (selectType == TextSelectType::Paragraphs) {
 
 			// Full selection of monospace entity.
 			for (const auto &b : _blocks) {
@@ -1351,6 +1756,57 @@ TextSelection String::adjustSelection(TextSelection selection, TextSelectType se
 	return { from, to };
 }
 
+TextSelection String::adjustParagraphSelection(
+		const HitTestIndex &index,
+		uint16 from,
+		uint16 to) const {
+	// Full selection of monospace entity.
+	const auto b = ranges::lower_bound(
+		_blocks,
+		from,
+		ranges::less(),
+		[](const Block &block) { return block->position(); });
+	if (b != end(_blocks) && IsMono((*b)->flags())) {
+		const auto &monos = index.monos;
+		auto i = ranges::upper_bound(
+			monos,
+			from,
+			ranges::less(),
+			&TextSelection::from);
+		auto found = end(monos);
+		while (i != begin(monos) && (i - 1)->to >= from) {
+			if ((--i)->to >= to) {
+				found = i;
+			}
+		}
+		if (found != end(monos)) {
+			from = found->from;
+			to = found->to;
+			while (to > 0 && IsSpace(_text.at(to - 1))) {
+				--to;
+			}
+			if (to >= from) {
+				return { from, to };
+			}
+		}
+	}
+
+	const auto &paragraphs = index.paragraphs;
+	const auto i = ranges::lower_bound(paragraphs, from);
+	if (i == end(paragraphs) || *i != from) {
+		from = (i == begin(paragraphs)) ? 0 : (*(i - 1) + 1);
+	}
+	if (to < _text.size()) {
+		const auto j = ranges::lower_bound(paragraphs, to);
+		to = (j == end(paragraphs))
+			? uint16(_text.size())
+			: (*j == to)
+			? uint16(to + 1)
+			: *j;
+	}
+	return { from, to };
+}
+
 bool String::isEmpty() const {
 	return _blocks.empty() || _blocks[0]->type() == TextBlockType::Skip;
 }
@@ -1604,6 +2060,9 @@ void String::unloadPersistentAnimation() {
 			}
 		}
 	}
+	if (hasSpoilers()) {
+		_extended->spoiler->animation.stop();
+	}
 }
 
 bool String::isOnlyCustomEmoji() const {
@@ -1862,6 +2321,8 @@ void String::clear() {
 	_text.clear();
 	_blocks.clear();
 	_extended = nullptr;
+	_hitTestIndex = nullptr;
+	_balancedWidth = BalancedWidth();
 	_maxWidth = _minHeight = 0;
 	_startQuoteIndex = 0;
 	_startParagraphLTR = false;
@@ -1996,9 +2457,7 @@ QSize CountOptimalTextSize(
 		return { text.maxWidth(), text.minHeight() };
 	}
 	const auto height = text.countHeight(maxWidth);
-	return { FindNiceTooltipWidth(minWidth, maxWidth, [&](int width) {
-		return text.countHeight(width);
-	}), height };
+	return { text.countBalancedWidth(minWidth, maxWidth), height };
 }
 
 } // namespace Ui::Text
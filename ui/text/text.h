@@ -86,6 +86,7 @@ struct OnlyCustomEmoji;
 struct SpoilerData;
 struct QuoteDetails;
 struct QuotesData;
+struct HitTestIndex;
 struct ExtendedData;
 struct MarkedContext;
 
@@ -144,8 +145,13 @@ public:
 	~SpoilerMessCache();
 
 	[[nodiscard]] not_null<SpoilerMessCached*> lookup(QColor color);
+	[[nodiscard]] not_null<SpoilerMessCached*> lookup(
+		const style::color &color);
 	void reset();
 
+	// Drops entries made for main palette colors that were changed.
+	void resetChanged();
+
 private:
 	struct Entry;
 
@@ -200,6 +206,8 @@ struct QuotePaintCache {
 	QColor icon;
 };
 
+// Takes the images from a shared atlas, generating them only for
+// the style and colors that were not painted recently.
 void ValidateQuotePaintCache(
 	QuotePaintCache &cache,
 	const style::QuoteStyle &st);
@@ -281,6 +289,13 @@ public:
 		int width,
 		bool breakEverywhere = false) const;
 
+	// Minimal width in [minWidth, maxWidth] with the same height as
+	// in maxWidth, so that the lines are filled as evenly as possible.
+	[[nodiscard]] int countBalancedWidth(
+		int minWidth,
+		int maxWidth,
+		bool breakEverywhere = false) const;
+
 	struct LineWidthsOptions {
 		bool breakEverywhere = false;
 		int reserve = 0;
@@ -423,6 +438,13 @@ private:
 
 	};
 
+	struct BalancedWidth {
+		int minWidth = -1;
+		int maxWidth = -1;
+		int result = 0;
+		bool breakEverywhere = false;
+	};
+
 	[[nodiscard]] not_null<ExtendedData*> ensureExtended();
 	[[nodiscard]] not_null<QuotesData*> ensureQuotes();
 
@@ -480,6 +502,18 @@ private:
 	void recountNaturalSize(
 		bool initial,
 		Qt::LayoutDirection optionsDir = Qt::LayoutDirectionAuto);
+	[[nodiscard]] int countBalancedWidthUncached(
+		int minWidth,
+		int maxWidth,
+		bool breakEverywhere) const;
+	[[nodiscard]] const HitTestIndex *hitTestIndex(
+		int width,
+		style::align align) const;
+	void indexParagraphs(HitTestIndex &index) const;
+	[[nodiscard]] TextSelection adjustParagraphSelection(
+		const HitTestIndex &index,
+		uint16 from,
+		uint16 to) const;
 
 	[[nodiscard]] TextForMimeData toText(
 		TextSelection selection,
@@ -491,6 +525,8 @@ private:
 	std::vector<Block> _blocks;
 	std::vector<Word> _words;
 	ExtendedWrap _extended;
+	mutable std::unique_ptr<HitTestIndex> _hitTestIndex;
+	mutable BalancedWidth _balancedWidth;
 
 	int _minResizeWidth = 0;
 	int _maxWidth = 0;
@@ -45,6 +45,103 @@ int AdjustCustomEmojiSize(int emojiSize) {
 	return base::SafeRound(emojiSize * 1.12);
 }
 
+void CustomEmoji::paintBatched(
+		QPainter &p,
+		const Context &context,
+		CustomEmojiBatch &batch) {
+	paint(p, context);
+}
+
+void CustomEmoji::repaintLater(crl::time when, crl::time duration) {
+}
+
+void CustomEmojiBatch::add(CustomEmojiBatchItem item) {
+	_items.push_back(item);
+}
+
+bool CustomEmojiBatch::empty() const {
+	return _items.empty();
+}
+
+void CustomEmojiBatch::paint(
+		QPainter &p,
+		CustomEmojiPaintContext context) {
+	if (_items.empty()) {
+		return;
+	}
+	const auto opacity = p.opacity();
+	auto current = opacity;
+	for (const auto &item : _items) {
+		if (current != item.opacity) {
+			current = item.opacity;
+			p.setOpacity(current);
+		}
+		context.textColor = item.textColor;
+		context.position = item.position;
+		item.emoji->paintBatched(p, context, *this);
+	}
+	_items.clear();
+	paintBlits(p);
+	if (p.opacity() != opacity) {
+		p.setOpacity(opacity);
+	}
+}
+
+void CustomEmojiBatch::paintBlits(QPainter &p) {
+	if (_blits.empty()) {
+		return;
+	}
+	// The same emoji repeated in a line is blitted from the same image.
+	std::stable_sort(begin(_blits), end(_blits), [](
+			const Blit &a,
+			const Blit &b) {
+		return a.image.cacheKey() < b.image.cacheKey();
+	});
+	auto current = p.opacity();
+	for (const auto &blit : _blits) {
+		if (current != blit.opacity) {
+			current = blit.opacity;
+			p.setOpacity(current);
+		}
+		p.drawImage(blit.target, blit.image, blit.source);
+	}
+	_blits.clear();
+}
+
+void CustomEmojiBatch::requestRepaint() {
+	if (const auto emoji = base::take(_repaint)) {
+		emoji->repaintLater(
+			base::take(_repaintWhen),
+			base::take(_repaintDuration));
+	}
+}
+
+void CustomEmojiBatch::drawImage(
+		const QPainter &p,
+		QRect target,
+		not_null<const QImage*> image,
+		QRect source) {
+	// The image is held by value: the emoji cache may be moved
+	// to another state before the blits are painted.
+	_blits.push_back({
+		.target = target,
+		.image = *image,
+		.source = source.isNull() ? image->rect() : source,
+		.opacity = p.opacity(),
+	});
+}
+
+void CustomEmojiBatch::repaintLater(
+		not_null<CustomEmoji*> emoji,
+		crl::time when,
+		crl::time duration) {
+	if (!_repaint || when < _repaintWhen) {
+		_repaint = emoji;
+		_repaintWhen = when;
+		_repaintDuration = duration;
+	}
+}
+
 ShiftedEmoji::ShiftedEmoji(
 	std::unique_ptr<Ui::Text::CustomEmoji> wrapped,
 	QPoint shift)
@@ -66,6 +163,15 @@ void ShiftedEmoji::paint(QPainter &p, const Context &context) {
 	_wrapped->paint(p, copy);
 }
 
+void ShiftedEmoji::paintBatched(
+		QPainter &p,
+		const Context &context,
+		CustomEmojiBatch &batch) {
+	auto copy = context;
+	copy.position += _shift;
+	_wrapped->paintBatched(p, copy, batch);
+}
+
 void ShiftedEmoji::unload() {
 	_wrapped->unload();
 }
@@ -97,6 +203,16 @@ void FirstFrameEmoji::paint(QPainter &p, const Context &context) {
 	context.internal.forceFirstFrame = was;
 }
 
+void FirstFrameEmoji::paintBatched(
+		QPainter &p,
+		const Context &context,
+		CustomEmojiBatch &batch) {
+	const auto was = context.internal.forceFirstFrame;
+	context.internal.forceFirstFrame = true;
+	_wrapped->paintBatched(p, context, batch);
+	context.internal.forceFirstFrame = was;
+}
+
 void FirstFrameEmoji::unload() {
 	_wrapped->unload();
 }
@@ -127,6 +243,27 @@ QString LimitedLoopsEmoji::entityData() {
 }
 
 void LimitedLoopsEmoji::paint(QPainter &p, const Context &context) {
+	paintWrapped(p, context, nullptr);
+}
+
+void LimitedLoopsEmoji::paintBatched(
+		QPainter &p,
+		const Context &context,
+		CustomEmojiBatch &batch) {
+	paintWrapped(p, context, &batch);
+}
+
+void LimitedLoopsEmoji::paintWrapped(
+		QPainter &p,
+		const Context &context,
+		CustomEmojiBatch *batch) {
+	const auto paintFrame = [&] {
+		if (batch) {
+			_wrapped->paintBatched(p, context, *batch);
+		} else {
+			_wrapped->paint(p, context);
+		}
+	};
 	if (_played < _limit) {
 		if (_wrapped->readyInDefaultState()) {
 			if (_inLoop) {
@@ -143,16 +280,16 @@ void LimitedLoopsEmoji::paint(QPainter &p, const Context &context) {
 		(_stopOnLast
 			? context.internal.forceLastFrame
 			: context.internal.forceFirstFrame) = true;
-		_wrapped->paint(p, context);
+		paintFrame();
 		context.internal.forceFirstFrame = wasFirst;
 		context.internal.forceLastFrame = wasLast;
 	} else if (_played + 1 == _limit && _inLoop && _stopOnLast) {
 		const auto wasLast = context.internal.overrideFirstWithLastFrame;
 		context.internal.overrideFirstWithLastFrame = true;
-		_wrapped->paint(p, context);
+		paintFrame();
 		context.internal.overrideFirstWithLastFrame = wasLast;
 	} else {
-		_wrapped->paint(p, context);
+		paintFrame();
 	}
 }
 
@@ -49,6 +49,8 @@ struct CustomEmojiPaintContext {
 	} internal;
 };
 
+class CustomEmojiBatch;
+
 class CustomEmoji {
 public:
 	virtual ~CustomEmoji() = default;
@@ -62,6 +64,66 @@ public:
 	[[nodiscard]] virtual bool ready() = 0;
 	[[nodiscard]] virtual bool readyInDefaultState() = 0;
 
+	// Paints as a part of a text, see CustomEmojiBatch.
+	// By default it is painted right away by paint().
+	virtual void paintBatched(
+		QPainter &p,
+		const Context &context,
+		CustomEmojiBatch &batch);
+
+	// The nearest next frame of a whole batch, passed to one of its emoji.
+	virtual void repaintLater(crl::time when, crl::time duration);
+
+};
+
+struct CustomEmojiBatchItem {
+	not_null<CustomEmoji*> emoji;
+	QPoint position;
+	QColor textColor;
+	float64 opacity = 1.;
+};
+
+// Custom emoji of one text painted together. The renderer adds the emoji
+// of a line and paints them after the line's text: the emoji that support
+// batching defer their frame blits to one pass, grouped by the frame image,
+// and report their next frame to the batch instead of asking for a repaint.
+// When the text is painted, the batch asks only the emoji with the nearest
+// next frame to repaint, the repaint of the text advances all of them.
+class CustomEmojiBatch final {
+public:
+	void add(CustomEmojiBatchItem item);
+	[[nodiscard]] bool empty() const;
+
+	void paint(QPainter &p, CustomEmojiPaintContext context);
+	void requestRepaint();
+
+	// For CustomEmoji::paintBatched() implementations.
+	void drawImage(
+		const QPainter &p,
+		QRect target,
+		not_null<const QImage*> image,
+		QRect source);
+	void repaintLater(
+		not_null<CustomEmoji*> emoji,
+		crl::time when,
+		crl::time duration);
+
+private:
+	struct Blit {
+		QRect target;
+		QImage image;
+		QRect source;
+		float64 opacity = 1.;
+	};
+
+	void paintBlits(QPainter &p);
+
+	std::vector<CustomEmojiBatchItem> _items;
+	std::vector<Blit> _blits;
+	CustomEmoji *_repaint = nullptr;
+	crl::time _repaintWhen = 0;
+	crl::time _repaintDuration = 0;
+
 };
 
 class ShiftedEmoji final : public CustomEmoji {
@@ -74,6 +136,10 @@ public:
 	void unload() override;
 	bool ready() override;
 	bool readyInDefaultState() override;
+	void paintBatched(
+		QPainter &p,
+		const Context &context,
+		CustomEmojiBatch &batch) override;
 
 private:
 	const std::unique_ptr<Ui::Text::CustomEmoji> _wrapped;
@@ -91,6 +157,10 @@ public:
 	void unload() override;
 	bool ready() override;
 	bool readyInDefaultState() override;
+	void paintBatched(
+		QPainter &p,
+		const Context &context,
+		CustomEmojiBatch &batch) override;
 
 private:
 	const std::unique_ptr<Ui::Text::CustomEmoji> _wrapped;
@@ -110,8 +180,17 @@ public:
 	void unload() override;
 	bool ready() override;
 	bool readyInDefaultState() override;
+	void paintBatched(
+		QPainter &p,
+		const Context &context,
+		CustomEmojiBatch &batch) override;
 
 private:
+	void paintWrapped(
+		QPainter &p,
+		const Context &context,
+		CustomEmojiBatch *batch);
+
 	const std::unique_ptr<Ui::Text::CustomEmoji> _wrapped;
 	const int _limit = 0;
 	int _played = 0;
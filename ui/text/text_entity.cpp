@@ -442,708 +442,247 @@ base::flat_set<int32> CreateValidTopDomains() {
 	return result;
 }
 
-// accent char list taken from https://github.com/aristus/accent-folding
-inline QChar RemoveOneAccent(uint32 code) {
-	switch (code) {
-	case 7834: return QChar(97);
-	case 193: return QChar(97);
-	case 225: return QChar(97);
-	case 192: return QChar(97);
-	case 224: return QChar(97);
-	case 258: return QChar(97);
-	case 259: return QChar(97);
-	case 7854: return QChar(97);
-	case 7855: return QChar(97);
-	case 7856: return QChar(97);
-	case 7857: return QChar(97);
-	case 7860: return QChar(97);
-	case 7861: return QChar(97);
-	case 7858: return QChar(97);
-	case 7859: return QChar(97);
-	case 194: return QChar(97);
-	case 226: return QChar(97);
-	case 7844: return QChar(97);
-	case 7845: return QChar(97);
-	case 7846: return QChar(97);
-	case 7847: return QChar(97);
-	case 7850: return QChar(97);
-	case 7851: return QChar(97);
-	case 7848: return QChar(97);
-	case 7849: return QChar(97);
-	case 461: return QChar(97);
-	case 462: return QChar(97);
-	case 197: return QChar(97);
-	case 229: return QChar(97);
-	case 506: return QChar(97);
-	case 507: return QChar(97);
-	case 196: return QChar(97);
-	case 228: return QChar(97);
-	case 478: return QChar(97);
-	case 479: return QChar(97);
-	case 195: return QChar(97);
-	case 227: return QChar(97);
-	case 550: return QChar(97);
-	case 551: return QChar(97);
-	case 480: return QChar(97);
-	case 481: return QChar(97);
-	case 260: return QChar(97);
-	case 261: return QChar(97);
-	case 256: return QChar(97);
-	case 257: return QChar(97);
-	case 7842: return QChar(97);
-	case 7843: return QChar(97);
-	case 512: return QChar(97);
-	case 513: return QChar(97);
-	case 514: return QChar(97);
-	case 515: return QChar(97);
-	case 7840: return QChar(97);
-	case 7841: return QChar(97);
-	case 7862: return QChar(97);
-	case 7863: return QChar(97);
-	case 7852: return QChar(97);
-	case 7853: return QChar(97);
-	case 7680: return QChar(97);
-	case 7681: return QChar(97);
-	case 570: return QChar(97);
-	case 11365: return QChar(97);
-	case 508: return QChar(97);
-	case 509: return QChar(97);
-	case 482: return QChar(97);
-	case 483: return QChar(97);
-	case 7682: return QChar(98);
-	case 7683: return QChar(98);
-	case 7684: return QChar(98);
-	case 7685: return QChar(98);
-	case 7686: return QChar(98);
-	case 7687: return QChar(98);
-	case 579: return QChar(98);
-	case 384: return QChar(98);
-	case 7532: return QChar(98);
-	case 385: return QChar(98);
-	case 595: return QChar(98);
-	case 386: return QChar(98);
-	case 387: return QChar(98);
-	case 262: return QChar(99);
-	case 263: return QChar(99);
-	case 264: return QChar(99);
-	case 265: return QChar(99);
-	case 268: return QChar(99);
-	case 269: return QChar(99);
-	case 266: return QChar(99);
-	case 267: return QChar(99);
-	case 199: return QChar(99);
-	case 231: return QChar(99);
-	case 7688: return QChar(99);
-	case 7689: return QChar(99);
-	case 571: return QChar(99);
-	case 572: return QChar(99);
-	case 391: return QChar(99);
-	case 392: return QChar(99);
-	case 597: return QChar(99);
-	case 270: return QChar(100);
-	case 271: return QChar(100);
-	case 7690: return QChar(100);
-	case 7691: return QChar(100);
-	case 7696: return QChar(100);
-	case 7697: return QChar(100);
-	case 7692: return QChar(100);
-	case 7693: return QChar(100);
-	case 7698: return QChar(100);
-	case 7699: return QChar(100);
-	case 7694: return QChar(100);
-	case 7695: return QChar(100);
-	case 272: return QChar(100);
-	case 273: return QChar(100);
-	case 7533: return QChar(100);
-	case 393: return QChar(100);
-	case 598: return QChar(100);
-	case 394: return QChar(100);
-	case 599: return QChar(100);
-	case 395: return QChar(100);
-	case 396: return QChar(100);
-	case 545: return QChar(100);
-	case 240: return QChar(100);
-	case 201: return QChar(101);
-	case 399: return QChar(101);
-	case 398: return QChar(101);
-	case 477: return QChar(101);
-	case 233: return QChar(101);
-	case 200: return QChar(101);
-	case 232: return QChar(101);
-	case 276: return QChar(101);
-	case 277: return QChar(101);
-	case 202: return QChar(101);
-	case 234: return QChar(101);
-	case 7870: return QChar(101);
-	case 7871: return QChar(101);
-	case 7872: return QChar(101);
-	case 7873: return QChar(101);
-	case 7876: return QChar(101);
-	case 7877: return QChar(101);
-	case 7874: return QChar(101);
-	case 7875: return QChar(101);
-	case 282: return QChar(101);
-	case 283: return QChar(101);
-	case 203: return QChar(101);
-	case 235: return QChar(101);
-	case 7868: return QChar(101);
-	case 7869: return QChar(101);
-	case 278: return QChar(101);
-	case 279: return QChar(101);
-	case 552: return QChar(101);
-	case 553: return QChar(101);
-	case 7708: return QChar(101);
-	case 7709: return QChar(101);
-	case 280: return QChar(101);
-	case 281: return QChar(101);
-	case 274: return QChar(101);
-	case 275: return QChar(101);
-	case 7702: return QChar(101);
-	case 7703: return QChar(101);
-	case 7700: return QChar(101);
-	case 7701: return QChar(101);
-	case 7866: return QChar(101);
-	case 7867: return QChar(101);
-	case 516: return QChar(101);
-	case 517: return QChar(101);
-	case 518: return QChar(101);
-	case 519: return QChar(101);
-	case 7864: return QChar(101);
-	case 7865: return QChar(101);
-	case 7878: return QChar(101);
-	case 7879: return QChar(101);
-	case 7704: return QChar(101);
-	case 7705: return QChar(101);
-	case 7706: return QChar(101);
-	case 7707: return QChar(101);
-	case 582: return QChar(101);
-	case 583: return QChar(101);
-	case 602: return QChar(101);
-	case 605: return QChar(101);
-	case 7710: return QChar(102);
-	case 7711: return QChar(102);
-	case 7534: return QChar(102);
-	case 401: return QChar(102);
-	case 402: return QChar(102);
-	case 500: return QChar(103);
-	case 501: return QChar(103);
-	case 286: return QChar(103);
-	case 287: return QChar(103);
-	case 284: return QChar(103);
-	case 285: return QChar(103);
-	case 486: return QChar(103);
-	case 487: return QChar(103);
-	case 288: return QChar(103);
-	case 289: return QChar(103);
-	case 290: return QChar(103);
-	case 291: return QChar(103);
-	case 7712: return QChar(103);
-	case 7713: return QChar(103);
-	case 484: return QChar(103);
-	case 485: return QChar(103);
-	case 403: return QChar(103);
-	case 608: return QChar(103);
-	case 292: return QChar(104);
-	case 293: return QChar(104);
-	case 542: return QChar(104);
-	case 543: return QChar(104);
-	case 7718: return QChar(104);
-	case 7719: return QChar(104);
-	case 7714: return QChar(104);
-	case 7715: return QChar(104);
-	case 7720: return QChar(104);
-	case 7721: return QChar(104);
-	case 7716: return QChar(104);
-	case 7717: return QChar(104);
-	case 7722: return QChar(104);
-	case 7723: return QChar(104);
-	case 817: return QChar(104);
-	case 7830: return QChar(104);
-	case 294: return QChar(104);
-	case 295: return QChar(104);
-	case 11367: return QChar(104);
-	case 11368: return QChar(104);
-	case 205: return QChar(105);
-	case 237: return QChar(105);
-	case 204: return QChar(105);
-	case 236: return QChar(105);
-	case 300: return QChar(105);
-	case 301: return QChar(105);
-	case 206: return QChar(105);
-	case 238: return QChar(105);
-	case 463: return QChar(105);
-	case 464: return QChar(105);
-	case 207: return QChar(105);
-	case 239: return QChar(105);
-	case 7726: return QChar(105);
-	case 7727: return QChar(105);
-	case 296: return QChar(105);
-	case 297: return QChar(105);
-	case 304: return QChar(105);
-	case 302: return QChar(105);
-	case 303: return QChar(105);
-	case 298: return QChar(105);
-	case 299: return QChar(105);
-	case 7880: return QChar(105);
-	case 7881: return QChar(105);
-	case 520: return QChar(105);
-	case 521: return QChar(105);
-	case 522: return QChar(105);
-	case 523: return QChar(105);
-	case 7882: return QChar(105);
-	case 7883: return QChar(105);
-	case 7724: return QChar(105);
-	case 7725: return QChar(105);
-	case 305: return QChar(105);
-	case 407: return QChar(105);
-	case 616: return QChar(105);
-	case 308: return QChar(106);
-	case 309: return QChar(106);
-	case 780: return QChar(106);
-	case 496: return QChar(106);
-	case 567: return QChar(106);
-	case 584: return QChar(106);
-	case 585: return QChar(106);
-	case 669: return QChar(106);
-	case 607: return QChar(106);
-	case 644: return QChar(106);
-	case 7728: return QChar(107);
-	case 7729: return QChar(107);
-	case 488: return QChar(107);
-	case 489: return QChar(107);
-	case 310: return QChar(107);
-	case 311: return QChar(107);
-	case 7730: return QChar(107);
-	case 7731: return QChar(107);
-	case 7732: return QChar(107);
-	case 7733: return QChar(107);
-	case 408: return QChar(107);
-	case 409: return QChar(107);
-	case 11369: return QChar(107);
-	case 11370: return QChar(107);
-	case 313: return QChar(97);
-	case 314: return QChar(108);
-	case 317: return QChar(108);
-	case 318: return QChar(108);
-	case 315: return QChar(108);
-	case 316: return QChar(108);
-	case 7734: return QChar(108);
-	case 7735: return QChar(108);
-	case 7736: return QChar(108);
-	case 7737: return QChar(108);
-	case 7740: return QChar(108);
-	case 7741: return QChar(108);
-	case 7738: return QChar(108);
-	case 7739: return QChar(108);
-	case 321: return QChar(108);
-	case 322: return QChar(108);
-	case 803: return QChar(108);
-	case 319: return QChar(108);
-	case 320: return QChar(108);
-	case 573: return QChar(108);
-	case 410: return QChar(108);
-	case 11360: return QChar(108);
-	case 11361: return QChar(108);
-	case 11362: return QChar(108);
-	case 619: return QChar(108);
-	case 620: return QChar(108);
-	case 621: return QChar(108);
-	case 564: return QChar(108);
-	case 7742: return QChar(109);
-	case 7743: return QChar(109);
-	case 7744: return QChar(109);
-	case 7745: return QChar(109);
-	case 7746: return QChar(109);
-	case 7747: return QChar(109);
-	case 625: return QChar(109);
-	case 323: return QChar(110);
-	case 324: return QChar(110);
-	case 504: return QChar(110);
-	case 505: return QChar(110);
-	case 327: return QChar(110);
-	case 328: return QChar(110);
-	case 209: return QChar(110);
-	case 241: return QChar(110);
-	case 7748: return QChar(110);
-	case 7749: return QChar(110);
-	case 325: return QChar(110);
-	case 326: return QChar(110);
-	case 7750: return QChar(110);
-	case 7751: return QChar(110);
-	case 7754: return QChar(110);
-	case 7755: return QChar(110);
-	case 7752: return QChar(110);
-	case 7753: return QChar(110);
-	case 413: return QChar(110);
-	case 626: return QChar(110);
-	case 544: return QChar(110);
-	case 414: return QChar(110);
-	case 627: return QChar(110);
-	case 565: return QChar(110);
-	case 776: return QChar(116);
-	case 211: return QChar(111);
-	case 243: return QChar(111);
-	case 210: return QChar(111);
-	case 242: return QChar(111);
-	case 334: return QChar(111);
-	case 335: return QChar(111);
-	case 212: return QChar(111);
-	case 244: return QChar(111);
-	case 7888: return QChar(111);
-	case 7889: return QChar(111);
-	case 7890: return QChar(111);
-	case 7891: return QChar(111);
-	case 7894: return QChar(111);
-	case 7895: return QChar(111);
-	case 7892: return QChar(111);
-	case 7893: return QChar(111);
-	case 465: return QChar(111);
-	case 466: return QChar(111);
-	case 214: return QChar(111);
-	case 246: return QChar(111);
-	case 554: return QChar(111);
-	case 555: return QChar(111);
-	case 336: return QChar(111);
-	case 337: return QChar(111);
-	case 213: return QChar(111);
-	case 245: return QChar(111);
-	case 7756: return QChar(111);
-	case 7757: return QChar(111);
-	case 7758: return QChar(111);
-	case 7759: return QChar(111);
-	case 556: return QChar(111);
-	case 557: return QChar(111);
-	case 558: return QChar(111);
-	case 559: return QChar(111);
-	case 560: return QChar(111);
-	case 561: return QChar(111);
-	case 216: return QChar(111);
-	case 248: return QChar(111);
-	case 510: return QChar(111);
-	case 511: return QChar(111);
-	case 490: return QChar(111);
-	case 491: return QChar(111);
-	case 492: return QChar(111);
-	case 493: return QChar(111);
-	case 332: return QChar(111);
-	case 333: return QChar(111);
-	case 7762: return QChar(111);
-	case 7763: return QChar(111);
-	case 7760: return QChar(111);
-	case 7761: return QChar(111);
-	case 7886: return QChar(111);
-	case 7887: return QChar(111);
-	case 524: return QChar(111);
-	case 525: return QChar(111);
-	case 526: return QChar(111);
-	case 527: return QChar(111);
-	case 416: return QChar(111);
-	case 417: return QChar(111);
-	case 7898: return QChar(111);
-	case 7899: return QChar(111);
-	case 7900: return QChar(111);
-	case 7901: return QChar(111);
-	case 7904: return QChar(111);
-	case 7905: return QChar(111);
-	case 7902: return QChar(111);
-	case 7903: return QChar(111);
-	case 7906: return QChar(111);
-	case 7907: return QChar(111);
-	case 7884: return QChar(111);
-	case 7885: return QChar(111);
-	case 7896: return QChar(111);
-	case 7897: return QChar(111);
-	case 415: return QChar(111);
-	case 629: return QChar(111);
-	case 7764: return QChar(112);
-	case 7765: return QChar(112);
-	case 7766: return QChar(112);
-	case 7767: return QChar(112);
-	case 11363: return QChar(112);
-	case 420: return QChar(112);
-	case 421: return QChar(112);
-	case 771: return QChar(112);
-	case 672: return QChar(113);
-	case 586: return QChar(113);
-	case 587: return QChar(113);
-	case 340: return QChar(114);
-	case 341: return QChar(114);
-	case 344: return QChar(114);
-	case 345: return QChar(114);
-	case 7768: return QChar(114);
-	case 7769: return QChar(114);
-	case 342: return QChar(114);
-	case 343: return QChar(114);
-	case 528: return QChar(114);
-	case 529: return QChar(114);
-	case 530: return QChar(114);
-	case 531: return QChar(114);
-	case 7770: return QChar(114);
-	case 7771: return QChar(114);
-	case 7772: return QChar(114);
-	case 7773: return QChar(114);
-	case 7774: return QChar(114);
-	case 7775: return QChar(114);
-	case 588: return QChar(114);
-	case 589: return QChar(114);
-	case 7538: return QChar(114);
-	case 636: return QChar(114);
-	case 11364: return QChar(114);
-	case 637: return QChar(114);
-	case 638: return QChar(114);
-	case 7539: return QChar(114);
-	case 223: return QChar(115);
-	case 346: return QChar(115);
-	case 347: return QChar(115);
-	case 7780: return QChar(115);
-	case 7781: return QChar(115);
-	case 348: return QChar(115);
-	case 349: return QChar(115);
-	case 352: return QChar(115);
-	case 353: return QChar(115);
-	case 7782: return QChar(115);
-	case 7783: return QChar(115);
-	case 7776: return QChar(115);
-	case 7777: return QChar(115);
-	case 7835: return QChar(115);
-	case 350: return QChar(115);
-	case 351: return QChar(115);
-	case 7778: return QChar(115);
-	case 7779: return QChar(115);
-	case 7784: return QChar(115);
-	case 7785: return QChar(115);
-	case 536: return QChar(115);
-	case 537: return QChar(115);
-	case 642: return QChar(115);
-	case 809: return QChar(115);
-	case 222: return QChar(116);
-	case 254: return QChar(116);
-	case 356: return QChar(116);
-	case 357: return QChar(116);
-	case 7831: return QChar(116);
-	case 7786: return QChar(116);
-	case 7787: return QChar(116);
-	case 354: return QChar(116);
-	case 355: return QChar(116);
-	case 7788: return QChar(116);
-	case 7789: return QChar(116);
-	case 538: return QChar(116);
-	case 539: return QChar(116);
-	case 7792: return QChar(116);
-	case 7793: return QChar(116);
-	case 7790: return QChar(116);
-	case 7791: return QChar(116);
-	case 358: return QChar(116);
-	case 359: return QChar(116);
-	case 574: return QChar(116);
-	case 11366: return QChar(116);
-	case 7541: return QChar(116);
-	case 427: return QChar(116);
-	case 428: return QChar(116);
-	case 429: return QChar(116);
-	case 430: return QChar(116);
-	case 648: return QChar(116);
-	case 566: return QChar(116);
-	case 218: return QChar(117);
-	case 250: return QChar(117);
-	case 217: return QChar(117);
-	case 249: return QChar(117);
-	case 364: return QChar(117);
-	case 365: return QChar(117);
-	case 219: return QChar(117);
-	case 251: return QChar(117);
-	case 467: return QChar(117);
-	case 468: return QChar(117);
-	case 366: return QChar(117);
-	case 367: return QChar(117);
-	case 220: return QChar(117);
-	case 252: return QChar(117);
-	case 471: return QChar(117);
-	case 472: return QChar(117);
-	case 475: return QChar(117);
-	case 476: return QChar(117);
-	case 473: return QChar(117);
-	case 474: return QChar(117);
-	case 469: return QChar(117);
-	case 470: return QChar(117);
-	case 368: return QChar(117);
-	case 369: return QChar(117);
-	case 360: return QChar(117);
-	case 361: return QChar(117);
-	case 7800: return QChar(117);
-	case 7801: return QChar(117);
-	case 370: return QChar(117);
-	case 371: return QChar(117);
-	case 362: return QChar(117);
-	case 363: return QChar(117);
-	case 7802: return QChar(117);
-	case 7803: return QChar(117);
-	case 7910: return QChar(117);
-	case 7911: return QChar(117);
-	case 532: return QChar(117);
-	case 533: return QChar(117);
-	case 534: return QChar(117);
-	case 535: return QChar(117);
-	case 431: return QChar(117);
-	case 432: return QChar(117);
-	case 7912: return QChar(117);
-	case 7913: return QChar(117);
-	case 7914: return QChar(117);
-	case 7915: return QChar(117);
-	case 7918: return QChar(117);
-	case 7919: return QChar(117);
-	case 7916: return QChar(117);
-	case 7917: return QChar(117);
-	case 7920: return QChar(117);
-	case 7921: return QChar(117);
-	case 7908: return QChar(117);
-	case 7909: return QChar(117);
-	case 7794: return QChar(117);
-	case 7795: return QChar(117);
-	case 7798: return QChar(117);
-	case 7799: return QChar(117);
-	case 7796: return QChar(117);
-	case 7797: return QChar(117);
-	case 580: return QChar(117);
-	case 649: return QChar(117);
-	case 7804: return QChar(118);
-	case 7805: return QChar(118);
-	case 7806: return QChar(118);
-	case 7807: return QChar(118);
-	case 434: return QChar(118);
-	case 651: return QChar(118);
-	case 7810: return QChar(119);
-	case 7811: return QChar(119);
-	case 7808: return QChar(119);
-	case 7809: return QChar(119);
-	case 372: return QChar(119);
-	case 373: return QChar(119);
-	case 778: return QChar(121);
-	case 7832: return QChar(119);
-	case 7812: return QChar(119);
-	case 7813: return QChar(119);
-	case 7814: return QChar(119);
-	case 7815: return QChar(119);
-	case 7816: return QChar(119);
-	case 7817: return QChar(119);
-	case 7820: return QChar(120);
-	case 7821: return QChar(120);
-	case 7818: return QChar(120);
-	case 7819: return QChar(120);
-	case 221: return QChar(121);
-	case 253: return QChar(121);
-	case 7922: return QChar(121);
-	case 7923: return QChar(121);
-	case 374: return QChar(121);
-	case 375: return QChar(121);
-	case 7833: return QChar(121);
-	case 376: return QChar(121);
-	case 255: return QChar(121);
-	case 7928: return QChar(121);
-	case 7929: return QChar(121);
-	case 7822: return QChar(121);
-	case 7823: return QChar(121);
-	case 562: return QChar(121);
-	case 563: return QChar(121);
-	case 7926: return QChar(121);
-	case 7927: return QChar(121);
-	case 7924: return QChar(121);
-	case 7925: return QChar(121);
-	case 655: return QChar(121);
-	case 590: return QChar(121);
-	case 591: return QChar(121);
-	case 435: return QChar(121);
-	case 436: return QChar(121);
-	case 377: return QChar(122);
-	case 378: return QChar(122);
-	case 7824: return QChar(122);
-	case 7825: return QChar(122);
-	case 381: return QChar(122);
-	case 382: return QChar(122);
-	case 379: return QChar(122);
-	case 380: return QChar(122);
-	case 7826: return QChar(122);
-	case 7827: return QChar(122);
-	case 7828: return QChar(122);
-	case 7829: return QChar(122);
-	case 437: return QChar(122);
-	case 438: return QChar(122);
-	case 548: return QChar(122);
-	case 549: return QChar(122);
-	case 656: return QChar(122);
-	case 657: return QChar(122);
-	case 11371: return QChar(122);
-	case 11372: return QChar(122);
-	case 494: return QChar(122);
-	case 495: return QChar(122);
-	case 442: return QChar(122);
-	case 65298: return QChar(50);
-	case 65302: return QChar(54);
-	case 65314: return QChar(66);
-	case 65318: return QChar(70);
-	case 65322: return QChar(74);
-	case 65326: return QChar(78);
-	case 65330: return QChar(82);
-	case 65334: return QChar(86);
-	case 65338: return QChar(90);
-	case 65346: return QChar(98);
-	case 65350: return QChar(102);
-	case 65354: return QChar(106);
-	case 65358: return QChar(110);
-	case 65362: return QChar(114);
-	case 65366: return QChar(118);
-	case 65370: return QChar(122);
-	case 65297: return QChar(49);
-	case 65301: return QChar(53);
-	case 65305: return QChar(57);
-	case 65313: return QChar(65);
-	case 65317: return QChar(69);
-	case 65321: return QChar(73);
-	case 65325: return QChar(77);
-	case 65329: return QChar(81);
-	case 65333: return QChar(85);
-	case 65337: return QChar(89);
-	case 65345: return QChar(97);
-	case 65349: return QChar(101);
-	case 65353: return QChar(105);
-	case 65357: return QChar(109);
-	case 65361: return QChar(113);
-	case 65365: return QChar(117);
-	case 65369: return QChar(121);
-	case 65296: return QChar(48);
-	case 65300: return QChar(52);
-	case 65304: return QChar(56);
-	case 65316: return QChar(68);
-	case 65320: return QChar(72);
-	case 65324: return QChar(76);
-	case 65328: return QChar(80);
-	case 65332: return QChar(84);
-	case 65336: return QChar(88);
-	case 65348: return QChar(100);
-	case 65352: return QChar(104);
-	case 65356: return QChar(108);
-	case 65360: return QChar(112);
-	case 65364: return QChar(116);
-	case 65368: return QChar(120);
-	case 65299: return QChar(51);
-	case 65303: return QChar(55);
-	case 65315: return QChar(67);
-	case 65319: return QChar(71);
-	case 65323: return QChar(75);
-	case 65327: return QChar(79);
-	case 65331: return QChar(83);
-	case 65335: return QChar(87);
-	case 65347: return QChar(99);
-	case 65351: return QChar(103);
-	case 65355: return QChar(107);
-	case 65359: return QChar(111);
-	case 65363: return QChar(115);
-	case 65367: return QChar(119);
-	case 1105: return QChar(1077);
-	default:
-	break;
+// Accent char list taken from https://github.com/aristus/accent-folding
+// as a two-level table: kAccentPages maps the high byte of a BMP code
+// to a 1-based row of kAccentFolds, zero means nothing to fold there.
+constexpr auto kAccentPagesCount = 9;
+
+constexpr auto kAccentPages = std::array<uint8, 256>{ {
+	1, 2, 3, 4, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 6, 7, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 8, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 9,
+} };
+
+constexpr auto kAccentFolds = std::array<
+	std::array<char16_t, 256>,
+	kAccentPagesCount>{ {
+	{ { // 0x0000
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		97, 97, 97, 97, 97, 97, 0, 99, 101, 101, 101, 101, 105, 105, 105, 105,
+		0, 110, 111, 111, 111, 111, 111, 0, 111, 117, 117, 117, 117, 121, 116, 115,
+		97, 97, 97, 97, 97, 97, 0, 99, 101, 101, 101, 101, 105, 105, 105, 105,
+		100, 110, 111, 111, 111, 111, 111, 0, 111, 117, 117, 117, 117, 121, 116, 121,
+	} },
+	{ { // 0x0100
+		97, 97, 97, 97, 97, 97, 99, 99, 99, 99, 99, 99, 99, 99, 100, 100,
+		100, 100, 101, 101, 101, 101, 101, 101, 101, 101, 101, 101, 103, 103, 103, 103,
+		103, 103, 103, 103, 104, 104, 104, 104, 105, 105, 105, 105, 105, 105, 105, 105,
+		105, 105, 0, 0, 106, 106, 107, 107, 0, 97, 108, 108, 108, 108, 108, 108,
+		108, 108, 108, 110, 110, 110, 110, 110, 110, 0, 0, 0, 111, 111, 111, 111,
+		111, 111, 0, 0, 114, 114, 114, 114, 114, 114, 115, 115, 115, 115, 115, 115,
+		115, 115, 116, 116, 116, 116, 116, 116, 117, 117, 117, 117, 117, 117, 117, 117,
+		117, 117, 117, 117, 119, 119, 121, 121, 121, 122, 122, 122, 122, 122, 122, 0,
+		98, 98, 98, 98, 0, 0, 0, 99, 99, 100, 100, 100, 100, 0, 101, 101,
+		0, 102, 102, 103, 0, 0, 0, 105, 107, 107, 108, 0, 0, 110, 110, 111,
+		111, 111, 0, 0, 112, 112, 0, 0, 0, 0, 0, 116, 116, 116, 116, 117,
+		117, 0, 118, 121, 121, 122, 122, 0, 0, 0, 122, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 97, 97, 105,
+		105, 111, 111, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 101, 97, 97,
+		97, 97, 97, 97, 103, 103, 103, 103, 107, 107, 111, 111, 111, 111, 122, 122,
+		106, 0, 0, 0, 103, 103, 0, 0, 110, 110, 97, 97, 97, 97, 111, 111,
+	} },
+	{ { // 0x0200
+		97, 97, 97, 97, 101, 101, 101, 101, 105, 105, 105, 105, 111, 111, 111, 111,
+		114, 114, 114, 114, 117, 117, 117, 117, 115, 115, 116, 116, 0, 0, 104, 104,
+		110, 100, 0, 0, 122, 122, 97, 97, 101, 101, 111, 111, 111, 111, 111, 111,
+		111, 111, 121, 121, 108, 110, 116, 106, 0, 0, 97, 99, 99, 108, 116, 0,
+		0, 0, 0, 98, 117, 0, 101, 101, 106, 106, 113, 113, 114, 114, 121, 121,
+		0, 0, 0, 98, 0, 99, 100, 100, 0, 0, 101, 0, 0, 101, 0, 106,
+		103, 0, 0, 0, 0, 0, 0, 0, 105, 0, 0, 108, 108, 108, 0, 0,
+		0, 109, 110, 110, 0, 111, 0, 0, 0, 0, 0, 0, 114, 114, 114, 0,
+		0, 0, 115, 0, 106, 0, 0, 0, 116, 117, 0, 118, 0, 0, 0, 121,
+		122, 122, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 106, 0, 0,
+		113, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	} },
+	{ { // 0x0300
+		0, 0, 0, 112, 0, 0, 0, 0, 116, 0, 121, 0, 106, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 108, 0, 0, 0, 0, 0, 115, 0, 0, 0, 0, 0, 0,
+		0, 104, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	} },
+	{ { // 0x0400
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 1077, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	} },
+	{ { // 0x1D00
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 98, 100, 102, 0,
+		0, 0, 114, 114, 0, 116, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	} },
+	{ { // 0x1E00
+		97, 97, 98, 98, 98, 98, 98, 98, 99, 99, 100, 100, 100, 100, 100, 100,
+		100, 100, 100, 100, 101, 101, 101, 101, 101, 101, 101, 101, 101, 101, 102, 102,
+		103, 103, 104, 104, 104, 104, 104, 104, 104, 104, 104, 104, 105, 105, 105, 105,
+		107, 107, 107, 107, 107, 107, 108, 108, 108, 108, 108, 108, 108, 108, 109, 109,
+		109, 109, 109, 109, 110, 110, 110, 110, 110, 110, 110, 110, 111, 111, 111, 111,
+		111, 111, 111, 111, 112, 112, 112, 112, 114, 114, 114, 114, 114, 114, 114, 114,
+		115, 115, 115, 115, 115, 115, 115, 115, 115, 115, 116, 116, 116, 116, 116, 116,
+		116, 116, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 118, 118, 118, 118,
+		119, 119, 119, 119, 119, 119, 119, 119, 119, 119, 120, 120, 120, 120, 121, 121,
+		122, 122, 122, 122, 122, 122, 104, 116, 119, 121, 97, 115, 0, 0, 0, 0,
+		97, 97, 97, 97, 97, 97, 97, 97, 97, 97, 97, 97, 97, 97, 97, 97,
+		97, 97, 97, 97, 97, 97, 97, 97, 101, 101, 101, 101, 101, 101, 101, 101,
+		101, 101, 101, 101, 101, 101, 101, 101, 105, 105, 105, 105, 111, 111, 111, 111,
+		111, 111, 111, 111, 111, 111, 111, 111, 111, 111, 111, 111, 111, 111, 111, 111,
+		111, 111, 111, 111, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117, 117,
+		117, 117, 121, 121, 121, 121, 121, 121, 121, 121, 0, 0, 0, 0, 0, 0,
+	} },
+	{ { // 0x2C00
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		108, 108, 108, 112, 114, 97, 116, 104, 104, 107, 107, 122, 122, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	} },
+	{ { // 0xFF00
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 0, 0, 0, 0, 0, 0,
+		0, 65, 66, 67, 68, 69, 70, 71, 72, 73, 74, 75, 76, 77, 78, 79,
+		80, 81, 82, 83, 84, 85, 86, 87, 88, 89, 90, 0, 0, 0, 0, 0,
+		0, 97, 98, 99, 100, 101, 102, 103, 104, 105, 106, 107, 108, 109, 110, 111,
+		112, 113, 114, 115, 116, 117, 118, 119, 120, 121, 122, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	} },
+} };
+
+[[nodiscard]] QChar FoldAccent(uint32 code) {
+	if (code >= 0x10000) {
+		return QChar(0);
+	}
+	const auto page = kAccentPages[code >> 8];
+	return page ? QChar(kAccentFolds[page - 1][code & 0xFF]) : QChar(0);
+}
+
+// Length of the plain ASCII start of the text, four code units at once.
+[[nodiscard]] int CountAsciiPrefix(const QChar *from, const QChar *till) {
+	constexpr auto kNotAscii = 0xFF80FF80FF80FF80ULL;
+	auto ch = from;
+	for (; till - ch >= 4; ch += 4) {
+		auto chunk = uint64();
+		memcpy(&chunk, ch, sizeof(chunk));
+		if (chunk & kNotAscii) {
+			break;
+		}
+	}
+	while (ch != till && ch->unicode() < 128) {
+		++ch;
+	}
+	return int(ch - from);
+}
+
+// Same as splitting by RegExpWordSplit(), where \s matches only
+// the ASCII whitespace, because it has no UseUnicodePropertiesOption.
+[[nodiscard]] bool IsSearchWordSeparator(QChar ch) {
+	switch (ch.unicode()) {
+	case '@': case '-': case '+': case '(': case ')': case '[': case ']':
+	case '{': case '}': case '<': case '>': case ',': case '.': case ':':
+	case '!': case '_': case ';': case '"': case '\'': case 0:
+	case ' ': case '\t': case '\n': case '\v': case '\f': case '\r':
+		return true;
+	}
+	return false;
+}
+
+template <typename Callback>
+void EnumerateSearchWords(QStringView text, Callback &&callback) {
+	auto from = 0;
+	const auto size = int(text.size());
+	for (auto i = 0; i <= size; ++i) {
+		if (i == size || IsSearchWordSeparator(text[i])) {
+			if (i > from) {
+				callback(from, i - from);
+			}
+			from = i + 1;
+		}
 	}
-	return QChar(0);
 }
 
 const QRegularExpression &RegExpWordSplit() {
@@ -1361,10 +900,16 @@ TextWithEntities SingleLine(const TextWithEntities &text) {
 }
 
 QString RemoveAccents(const QString &text) {
+	const auto ascii = CountAsciiPrefix(
+		text.unicode(),
+		text.unicode() + text.size());
+	if (ascii == text.size()) {
+		return text;
+	}
 	auto result = text;
 	auto copying = false;
-	auto i = 0;
-	for (auto s = text.unicode(), ch = s, e = text.unicode() + text.size(); ch != e; ++ch, ++i) {
+	auto i = ascii;
+	for (auto s = text.unicode(), ch = s + ascii, e = text.unicode() + text.size(); ch != e; ++ch, ++i) {
 		if (ch->unicode() < 128) {
 			if (copying) result[i] = *ch;
 			continue;
@@ -1375,7 +920,7 @@ QString RemoveAccents(const QString &text) {
 			continue;
 		}
 		if (ch->isHighSurrogate() && ch + 1 < e && (ch + 1)->isLowSurrogate()) {
-			auto noAccent = RemoveOneAccent(QChar::surrogateToUcs4(*ch, *(ch + 1)));
+			auto noAccent = FoldAccent(QChar::surrogateToUcs4(*ch, *(ch + 1)));
 			if (noAccent.unicode() > 0) {
 				copying = true;
 				result[i] = noAccent;
@@ -1385,7 +930,7 @@ QString RemoveAccents(const QString &text) {
 				if (copying) result[i] = *ch;
 			}
 		} else {
-			auto noAccent = RemoveOneAccent(ch->unicode());
+			auto noAccent = FoldAccent(ch->unicode());
 			if (noAccent.unicode() > 0 && noAccent != *ch) {
 				result[i] = noAccent;
 			} else if (copying) {
@@ -1397,19 +942,19 @@ QString RemoveAccents(const QString &text) {
 }
 
 QString RemoveEmoji(const QString &text) {
+	const auto found = Ui::Emoji::FindAll(text);
+	if (found.empty()) {
+		return text;
+	}
 	auto result = QString();
 	result.reserve(text.size());
 
-	auto begin = text.data();
-	const auto end = begin + text.size();
-	while (begin != end) {
-		auto length = 0;
-		if (Ui::Emoji::Find(begin, end, &length)) {
-			begin += length;
-		} else {
-			result.append(*begin++);
-		}
+	auto from = 0;
+	for (const auto &emoji : found) {
+		result.append(base::StringViewMid(text, from, emoji.position - from));
+		from = emoji.position + emoji.length;
 	}
+	result.append(base::StringViewMid(text, from));
 	return result;
 }
 
@@ -1422,7 +967,11 @@ QStringList PrepareSearchWords(
 		const QRegularExpression *SplitterOverride) {
 	auto clean = RemoveAccents(query.trimmed().toLower());
 	auto result = QStringList();
-	if (!clean.isEmpty()) {
+	if (!clean.isEmpty() && !SplitterOverride) {
+		EnumerateSearchWords(clean, [&](int from, int length) {
+			result.push_back(clean.mid(from, length));
+		});
+	} else if (!clean.isEmpty()) {
 		auto list = clean.split(SplitterOverride
 			? *SplitterOverride
 			: RegExpWordSplit(),
@@ -1438,6 +987,51 @@ QStringList PrepareSearchWords(
 	return result;
 }
 
+SearchKey::SearchKey(const QString &text)
+: _text(RemoveAccents(text.trimmed().toLower())) {
+	EnumerateSearchWords(_text, [&](int from, int length) {
+		_words.push_back({ .from = from, .length = length });
+	});
+}
+
+QStringView SearchKey::word(int index) const {
+	Expects(index >= 0 && index < wordsCount());
+
+	const auto &word = _words[index];
+	return QStringView(_text).mid(word.from, word.length);
+}
+
+bool SearchKey::matchesPrefix(QStringView prefix) const {
+	for (const auto &word : _words) {
+		if (word.length >= prefix.size()
+			&& QStringView(_text).mid(word.from, prefix.size()) == prefix) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool SearchKey::matches(const QStringList &words) const {
+	for (const auto &word : words) {
+		if (!matchesPrefix(word)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool SearchKey::matches(const SearchKey &query) const {
+	for (const auto &word : query._words) {
+		const auto prefix = QStringView(query._text).mid(
+			word.from,
+			word.length);
+		if (!matchesPrefix(prefix)) {
+			return false;
+		}
+	}
+	return true;
+}
+
 bool CutPart(TextWithEntities &sending, TextWithEntities &left, int32 limit) {
 	Expects(limit > 0);
 
@@ -334,6 +334,43 @@ QString RemoveAccents(const QString &text);
 QString RemoveEmoji(const QString &text);
 QString NameSortKey(const QString &text);
 QStringList PrepareSearchWords(const QString &query, const QRegularExpression *SplitterOverride = nullptr);
+
+// Folded and lowered words of a text, prepared once to match it against
+// many search queries without allocations.
+class SearchKey {
+public:
+	SearchKey() = default;
+	explicit SearchKey(const QString &text);
+
+	[[nodiscard]] const QString &text() const {
+		return _text;
+	}
+	[[nodiscard]] int wordsCount() const {
+		return int(_words.size());
+	}
+	[[nodiscard]] QStringView word(int index) const;
+
+	// Some word starts with the prefix.
+	[[nodiscard]] bool matchesPrefix(QStringView prefix) const;
+
+	// Every word from PrepareSearchWords() starts some of the words.
+	[[nodiscard]] bool matches(const QStringList &words) const;
+
+	// Every word of the query key starts some of the words.
+	// Prepare the query once, then match it without allocations.
+	[[nodiscard]] bool matches(const SearchKey &query) const;
+
+private:
+	struct Word {
+		int from = 0;
+		int length = 0;
+	};
+
+	QString _text;
+	std::vector<Word> _words;
+
+};
+
 bool CutPart(TextWithEntities &sending, TextWithEntities &left, int limit);
 
 struct MentionNameFields {
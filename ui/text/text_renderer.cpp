@@ -11,6 +11,7 @@
 #include "ui/text/text_extended_data.h"
 #include "ui/text/text_stack_engine.h"
 #include "ui/text/text_word.h"
+#include "ui/ui_trace.h"
 #include "styles/style_basic.h"
 
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
@@ -113,6 +114,7 @@ void Renderer::draw(QPainter &p, const PaintContext &context) {
 	if (_t->isEmpty()) {
 		return;
 	}
+	UI_TRACE_SCOPE("Text::draw");
 
 	_p = &p;
 	_p->setFont(_t->_st->font);
@@ -197,6 +199,8 @@ void Renderer::enumerate() {
 
 	const auto guard = gsl::finally([&] {
 		if (_p) {
+			paintCustomEmojiBatch();
+			_customEmojiBatch.requestRepaint();
 			paintSpoilerRects();
 		}
 		if (_highlight) {
@@ -359,7 +363,18 @@ void Renderer::fillParagraphBg(int paddingBottom) {
 				.collapseIcon = cutoff && _quote->expanded,
 			});
 		}
-		if (cutoff && _quoteExpandLinkLookup
+		if (cutoff && _index) {
+			_index->quoteLinks.push_back({
+				.rect = QRect(
+					left,
+					start,
+					_startLineWidth,
+					(_quoteLineTop + _lineHeight + paddingBottom - skip
+						- start)),
+				.quote = _quoteIndex,
+				.toggle = true,
+			});
+		} else if (cutoff && _quoteExpandLinkLookup
 			&& _lookupY >= start
 			&& _lookupY < _quoteLineTop + _lineHeight + paddingBottom - skip
 			&& _lookupX >= left
@@ -391,6 +406,12 @@ void Renderer::fillParagraphBg(int paddingBottom) {
 				} else {
 					_p->drawText(lbaseline, headerText);
 				}
+			} else if (_index) {
+				_index->quoteLinks.push_back({
+					.rect = QRect(left, top, _startLineWidth, st.header),
+					.quote = _quoteIndex,
+					.symbol = uint16(_lineStart),
+				});
 			} else if (_lookupX >= left
 				&& _lookupX < left + _startLineWidth
 				&& _lookupY >= top
@@ -531,6 +552,248 @@ void Renderer::initParagraphBidi() {
 	bidi.process();
 }
 
+void Renderer::buildHitTestIndex(
+		HitTestIndex &index,
+		GeometryDescriptor geometry) {
+	index.lines.clear();
+	index.items.clear();
+	index.chars.clear();
+	index.quoteLinks.clear();
+	index.built = true;
+	if (_t->isEmpty()) {
+		return;
+	}
+	_index = &index;
+	_geometry = std::move(geometry);
+	_breakEverywhere = _geometry.breakEverywhere;
+	_yFrom = std::numeric_limits<int>::min();
+	_yTo = -1;
+	_align = index.align;
+	enumerate();
+	_index = nullptr;
+}
+
+StateResult Renderer::getState(
+		QPoint point,
+		const HitTestIndex &index,
+		StateRequest request) {
+	if (_t->isEmpty() || point.y() < 0) {
+		return {};
+	}
+	_lookupRequest = request;
+	_lookupX = point.x();
+	_lookupY = point.y();
+
+	_lookupSymbol = (_lookupRequest.flags & StateRequest::Flag::LookupSymbol);
+	_lookupLink = (_lookupRequest.flags & StateRequest::Flag::LookupLink);
+	if (!_lookupSymbol && _lookupX < 0) {
+		return {};
+	}
+	_str = _t->_text.unicode();
+
+	// Lines above the point only move the symbol to their end.
+	const auto above = [&](const HitTestIndex::Line &line) {
+		return (line.top + line.fontHeight <= _lookupY);
+	};
+	const auto &lines = index.lines;
+	auto i = std::partition_point(begin(lines), end(lines), above);
+	if (i != begin(lines) && _lookupSymbol) {
+		const auto &line = *(i - 1);
+		const auto empty = (line.lineEnd <= line.lineStart);
+		_lookupResult.symbol = empty ? line.lineStart : (line.lineEnd - 1);
+		_lookupResult.afterSymbol = !empty;
+	}
+	const auto finish = [&] {
+		lookupIndexQuoteLinks(index);
+		return _lookupResult;
+	};
+	for (const auto &link : index.quoteLinks) {
+		if (!link.toggle && link.rect.contains(_lookupX, _lookupY)) {
+			// Quote headers are above the first line of their quote.
+			if (_lookupLink) {
+				_lookupResult.link = _t->quoteByIndex(link.quote)->copy;
+			}
+			if (_lookupSymbol) {
+				_lookupResult.symbol = link.symbol;
+				_lookupResult.afterSymbol = false;
+			}
+			return finish();
+		}
+	}
+	for (; i != end(lines); ++i) {
+		if (i->top > _lookupY || i->y > _lookupY) {
+			return finish();
+		} else if (!lookupIndexLine(index, *i)) {
+			return finish();
+		}
+	}
+	if (_lookupSymbol) {
+		_lookupResult.symbol = _t->_text.size();
+		_lookupResult.afterSymbol = false;
+	}
+	return finish();
+}
+
+void Renderer::lookupIndexQuoteLinks(const HitTestIndex &index) {
+	if (!_lookupLink || _lookupResult.link) {
+		return;
+	}
+	for (const auto &link : index.quoteLinks) {
+		if (link.toggle && link.rect.contains(_lookupX, _lookupY)) {
+			_lookupResult.link = _t->quoteByIndex(link.quote)->toggle;
+			return;
+		}
+	}
+}
+
+bool Renderer::lookupIndexLine(
+		const HitTestIndex &index,
+		const HitTestIndex::Line &line) {
+	const auto lineStart = line.lineStart;
+	const auto lineEnd = line.lineEnd;
+	const auto setSymbol = [&](bool atStart) {
+		if (atStart || lineEnd <= lineStart) {
+			_lookupResult.symbol = lineStart;
+			_lookupResult.afterSymbol = false;
+		} else {
+			_lookupResult.symbol = lineEnd - 1;
+			_lookupResult.afterSymbol = true;
+		}
+	};
+	if (_lookupX < line.left) {
+		if (_lookupSymbol) {
+			setSymbol(!line.rtl);
+		}
+		if (_lookupLink) {
+			_lookupResult.link = nullptr;
+		}
+		_lookupResult.uponSymbol = false;
+		return false;
+	} else if (_lookupX >= line.right) {
+		setSymbol(line.rtl);
+		if (_lookupLink) {
+			_lookupResult.link = nullptr;
+		}
+		_lookupResult.uponSymbol = false;
+		return false;
+	}
+	for (auto j = line.itemsFrom; j != line.itemsTill; ++j) {
+		const auto &item = index.items[j];
+		if (_lookupX < item.left || _lookupX >= item.right) {
+			continue;
+		}
+		if (_lookupLink
+			&& _lookupY >= line.top
+			&& _lookupY < line.top + line.fontHeight) {
+			const auto block = _t->_blocks[item.block].get();
+			if (const auto link = lookupLink(block)) {
+				_lookupResult.link = link;
+			}
+		}
+		if (!item.skip) {
+			_lookupResult.uponSymbol = true;
+		}
+		if (!_lookupSymbol) {
+			return false;
+		} else if (item.skip) {
+			const auto trimmed = line.trimmedLineEnd;
+			if (line.rtl || trimmed <= lineStart) {
+				_lookupResult.symbol = lineStart;
+				_lookupResult.afterSymbol = false;
+			} else {
+				_lookupResult.symbol = trimmed - 1;
+				_lookupResult.afterSymbol = true;
+			}
+			return false;
+		}
+		const auto from = item.symbolFrom;
+		const auto till = item.symbolTill;
+		if (item.object) {
+			if (_lookupX < item.middle) {
+				_lookupResult.symbol = (item.rtl && till > from)
+					? (till - 1)
+					: from;
+				_lookupResult.afterSymbol = (item.rtl && till > from);
+			} else {
+				_lookupResult.symbol = (item.rtl || till <= from)
+					? from
+					: (till - 1);
+				_lookupResult.afterSymbol = !(item.rtl || till <= from);
+			}
+			return false;
+		}
+		const auto before = [&](QFixed edge) {
+			return item.rtl ? (_lookupX >= edge) : (_lookupX < edge);
+		};
+		for (auto k = item.charsFrom; k != item.charsTill; ++k) {
+			const auto &ch = index.chars[k];
+			if (before(ch.symbolEdge)) {
+				_lookupResult.symbol = ch.symbol;
+				_lookupResult.afterSymbol = !before(ch.afterEdge);
+				return false;
+			}
+		}
+		if (till > from) {
+			_lookupResult.symbol = till - 1;
+			_lookupResult.afterSymbol = true;
+		} else {
+			_lookupResult.symbol = from;
+			_lookupResult.afterSymbol = false;
+		}
+		return false;
+	}
+	return true;
+}
+
+void Renderer::indexTextItem(
+		const QScriptItem &si,
+		const unsigned short *logClusters,
+		const QGlyphLayout &glyphs,
+		int itemStart,
+		int itemEnd,
+		QFixed x,
+		QFixed itemWidth,
+		Blocks::const_iterator blockIt) {
+	const auto rtl = (si.analysis.bidiLevel % 2) != 0;
+	const auto charsFrom = int(_index->chars.size());
+
+	// Same glyph edges as the symbol lookup in drawLine().
+	auto tmpx = rtl ? (x + itemWidth) : x;
+	for (int ch = 0, g, itemL = itemEnd - itemStart; ch < itemL;) {
+		g = logClusters[itemStart - si.position + ch];
+		const auto gwidth = glyphs.effectiveAdvance(g);
+		int ch2 = ch + 1;
+		while ((ch2 < itemL) && (g == logClusters[itemStart - si.position + ch2])) {
+			++ch2;
+		}
+		for (int charsCount = (ch2 - ch); ch < ch2; ++ch) {
+			const auto shift1 = QFixed(2 * (charsCount - (ch2 - ch)) + 2) * gwidth / QFixed(2 * charsCount);
+			const auto shift2 = QFixed(2 * (charsCount - (ch2 - ch)) + 1) * gwidth / QFixed(2 * charsCount);
+			_index->chars.push_back({
+				.symbolEdge = rtl ? (tmpx - shift1) : (tmpx + shift1),
+				.afterEdge = rtl ? (tmpx - shift2) : (tmpx + shift2),
+				.symbol = uint16(_localFrom + itemStart + ch),
+			});
+		}
+		if (rtl) {
+			tmpx -= gwidth;
+		} else {
+			tmpx += gwidth;
+		}
+	}
+	_index->items.push_back({
+		.left = x,
+		.right = x + itemWidth,
+		.block = int(blockIt - begin(_t->_blocks)),
+		.symbolFrom = uint16(_localFrom + itemStart),
+		.symbolTill = uint16(_localFrom + itemEnd),
+		.charsFrom = charsFrom,
+		.charsTill = int(_index->chars.size()),
+		.rtl = rtl,
+	});
+	_index->lines.back().itemsTill = int(_index->items.size());
+}
+
 bool Renderer::drawLine(uint16 lineEnd, Blocks::const_iterator blocksEnd) {
 	_yDelta = (_lineHeight - _fontHeight) / 2;
 	if (_yTo >= 0 && (_y + _yDelta >= _yTo || _y >= _yTo)) {
@@ -611,7 +874,22 @@ bool Renderer::drawLine(uint16 lineEnd, Blocks::const_iterator blocksEnd) {
 		x += _wLeft;
 	}
 
-	if (!_p) {
+	if (_index) {
+		const auto items = int(_index->items.size());
+		_index->lines.push_back({
+			.y = _y,
+			.top = _y + _yDelta,
+			.fontHeight = _fontHeight,
+			.left = x,
+			.right = x + (_lineWidth - _wLeft),
+			.lineStart = uint16(_lineStart),
+			.lineEnd = lineEnd,
+			.trimmedLineEnd = trimmedLineEnd,
+			.rtl = (_paragraphDirection == Qt::RightToLeft),
+			.itemsFrom = items,
+			.itemsTill = items,
+		});
+	} else if (!_p) {
 		if (_lookupX < x) {
 			if (_lookupSymbol) {
 				if (_paragraphDirection == Qt::RightToLeft) {
@@ -682,6 +960,7 @@ bool Renderer::drawLine(uint16 lineEnd, Blocks::const_iterator blocksEnd) {
 		? (_lineWidth.toReal() - _f->elidew) / 2.
 		: -1;
 	auto rightLineLengthLeft = leftLineLengthLeft;
+	UI_TRACE_SCOPE("Text::drawLine");
 	auto engine = StackEngine(
 		_t,
 		_localFrom,
@@ -740,7 +1019,28 @@ bool Renderer::drawLine(uint16 lineEnd, Blocks::const_iterator blocksEnd) {
 		applyBlockProperties(e, block);
 		if (si.analysis.flags >= QScriptAnalysis::TabOrObject) {
 			const auto _type = block->type();
-			if (!_p && _lookupX >= x && _lookupX < x + si.width) { // _lookupRequest
+			if (_index) {
+				auto chFrom = _t->blockPosition(blockIt);
+				auto chTo = _t->blockEnd(blockIt);
+				while (chTo > chFrom && _str[chTo - 1].unicode() == QChar::Space) {
+					--chTo;
+				}
+				_index->items.push_back({
+					.left = x,
+					.right = x + si.width,
+					.middle = ((_type == TextBlockType::Emoji
+						|| _type == TextBlockType::CustomEmoji)
+						? (x + (block->objectWidth() / 2))
+						: (x + si.width / 2)),
+					.block = int(blockIt - begin(_t->_blocks)),
+					.symbolFrom = chFrom,
+					.symbolTill = chTo,
+					.object = true,
+					.skip = (_type == TextBlockType::Skip),
+					.rtl = (rtl != 0),
+				});
+				_index->lines.back().itemsTill = int(_index->items.size());
+			} else if (!_p && _lookupX >= x && _lookupX < x + si.width) { // _lookupRequest
 				if (_elisionMiddle) {
 					return false;
 				}
@@ -869,14 +1169,16 @@ bool Renderer::drawLine(uint16 lineEnd, Blocks::const_iterator blocksEnd) {
 							};
 							_customEmojiSkip = (st::emojiSize
 								- AdjustCustomEmojiSize(st::emojiSize)) / 2;
-						} else {
-							_customEmojiContext->textColor = color;
 						}
-						_customEmojiContext->position = {
-							ex + _customEmojiSkip,
-							ey + _customEmojiSkip,
-						};
-						custom->paint(*_p, *_customEmojiContext);
+						_customEmojiBatch.add({
+							.emoji = custom,
+							.position = {
+								ex + _customEmojiSkip,
+								ey + _customEmojiSkip,
+							},
+							.textColor = color,
+							.opacity = _p->opacity(),
+						});
 					}
 					if (hasSpoiler) {
 						_p->setOpacity(opacity);
@@ -974,7 +1276,17 @@ bool Renderer::drawLine(uint16 lineEnd, Blocks::const_iterator blocksEnd) {
 			x -= itemWidth;
 		}
 
-		if (!_p && _lookupX >= x && _lookupX < x + itemWidth) { // _lookupRequest
+		if (_index) {
+			indexTextItem(
+				si,
+				logClusters,
+				glyphs,
+				itemStart,
+				itemEnd,
+				x,
+				itemWidth,
+				blockIt);
+		} else if (!_p && _lookupX >= x && _lookupX < x + itemWidth) { // _lookupRequest
 			if (_elisionMiddle) {
 				return false;
 			}
@@ -1169,10 +1481,20 @@ bool Renderer::drawLine(uint16 lineEnd, Blocks::const_iterator blocksEnd) {
 			x -= itemWidth;
 		}
 	}
+	if (_p) {
+		paintCustomEmojiBatch();
+	}
 	fillRectsFromRanges();
 	return !_elidedLine;
 }
 
+void Renderer::paintCustomEmojiBatch() {
+	if (_customEmojiBatch.empty()) {
+		return;
+	}
+	_customEmojiBatch.paint(*_p, *_customEmojiContext);
+}
+
 FixedRange Renderer::findSelectEmojiRange(
 		const QScriptItem &si,
 		std::vector<Block>::const_iterator blockIt,
@@ -1355,7 +1677,7 @@ void Renderer::paintSpoilerRects(
 	if (rects.empty()) {
 		return;
 	}
-	const auto frame = _spoilerCache->lookup(color->c)->frame(index);
+	const auto frame = _spoilerCache->lookup(color)->frame(index);
 	if (_spoilerCache) {
 		for (const auto &rect : rects) {
 			Ui::FillSpoilerRect(*_p, rect, frame, -rect.topLeft());
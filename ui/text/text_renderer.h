@@ -37,6 +37,62 @@ struct FixedRange {
 [[nodiscard]] FixedRange United(FixedRange a, FixedRange b);
 [[nodiscard]] bool Distinct(FixedRange a, FixedRange b);
 
+// Line and glyph positions of a laid out String for a single width,
+// so that repeated lookups don't shape the lines again.
+struct HitTestIndex {
+	struct Line {
+		int y = 0;
+		int top = 0; // Where the glyphs start, links are hit below it.
+		int fontHeight = 0;
+		QFixed left;
+		QFixed right;
+		uint16 lineStart = 0;
+		uint16 lineEnd = 0;
+		uint16 trimmedLineEnd = 0;
+		bool rtl = false;
+		int itemsFrom = 0;
+		int itemsTill = 0;
+	};
+	struct Item {
+		QFixed left;
+		QFixed right;
+		QFixed middle; // For objects.
+		int block = 0;
+		uint16 symbolFrom = 0;
+		uint16 symbolTill = 0;
+		int charsFrom = 0;
+		int charsTill = 0;
+		bool object = false;
+		bool skip = false;
+		bool rtl = false;
+	};
+	struct Char {
+		QFixed symbolEdge; // Before this edge the lookup hits the symbol.
+		QFixed afterEdge; // After this edge it is after the symbol.
+		uint16 symbol = 0;
+	};
+	struct QuoteLink {
+		QRect rect;
+		int quote = 0;
+		uint16 symbol = 0;
+		bool toggle = false; // Expand area, other links win over it.
+	};
+
+	int width = 0;
+	style::align align = style::al_topleft;
+	bool rtl = false;
+	bool built = false;
+
+	std::vector<Line> lines;
+	std::vector<Item> items;
+	std::vector<Char> chars;
+	std::vector<QuoteLink> quoteLinks;
+
+	// Width independent, for the selection adjustments.
+	std::vector<uint16> paragraphs; // Separator positions.
+	std::vector<TextSelection> monos; // Pre and Code entity ranges.
+};
+
 class Renderer final {
 public:
 	explicit Renderer(const Ui::Text::String &t);
@@ -48,6 +104,14 @@ public:
 		GeometryDescriptor geometry,
 		StateRequest request);
 
+	void buildHitTestIndex(
+		HitTestIndex &index,
+		GeometryDescriptor geometry);
+	[[nodiscard]] StateResult getState(
+		QPoint point,
+		const HitTestIndex &index,
+		StateRequest request);
+
 private:
 	static constexpr int kSpoilersRectsSize = 512;
 
@@ -78,6 +142,20 @@ private:
 		QFixed itemWidth,
 		const QTextItemInt &gf,
 		TextSelection selection) const;
+	void indexTextItem(
+		const QScriptItem &si,
+		const unsigned short *logClusters,
+		const QGlyphLayout &glyphs,
+		int itemStart,
+		int itemEnd,
+		QFixed x,
+		QFixed itemWidth,
+		Blocks::const_iterator blockIt);
+	[[nodiscard]] bool lookupIndexLine(
+		const HitTestIndex &index,
+		const HitTestIndex::Line &line);
+	void lookupIndexQuoteLinks(const HitTestIndex &index);
+	void paintCustomEmojiBatch();
 	void fillSelectRange(FixedRange range);
 	void pushHighlightRange(FixedRange range);
 	void pushSpoilerRange(
@@ -153,6 +231,7 @@ private:
 	QVarLengthArray<QRect, kSpoilersRectsSize> _highlightRects;
 
 	std::optional<CustomEmoji::Context> _customEmojiContext;
+	CustomEmojiBatch _customEmojiBatch;
 	int _customEmojiSkip = 0;
 	int _indexOfElidedBlock = -1; // For spoilers.
 
@@ -212,6 +291,7 @@ private:
 	bool _lookupLink = false;
 	StateRequest _lookupRequest;
 	StateResult _lookupResult;
+	HitTestIndex *_index = nullptr;
 
 	bool _elisionMiddle = false;
 
@@ -0,0 +1,140 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "ui/ui_trace.h"
+
+#include <QtCore/QCoreApplication>
+
+#include <atomic>
+#include <mutex>
+
+namespace Ui::Trace {
+namespace {
+
+constexpr auto kDefaultCapacity = 64 * 1024;
+
+struct Event {
+	const char *name = nullptr;
+	crl::profile_time start = 0;
+	crl::profile_time duration = 0;
+	int thread = 0;
+};
+
+struct Buffer {
+	std::mutex mutex;
+	std::vector<Event> events;
+	int capacity = kDefaultCapacity;
+	int next = 0;
+	bool full = false;
+};
+
+std::atomic<bool> TraceEnabled = false;
+std::atomic<int> ThreadCounter = 0;
+
+[[nodiscard]] Buffer &Instance() {
+	static auto result = Buffer();
+	return result;
+}
+
+[[nodiscard]] int CurrentThread() {
+	thread_local const auto result = ThreadCounter.fetch_add(1) + 1;
+	return result;
+}
+
+[[nodiscard]] QByteArray Escaped(const char *name) {
+	auto result = QByteArray(name);
+	return result.replace('\\', "\\\\").replace('"', "\\\"");
+}
+
+} // namespace
+
+void SetEnabled(bool enabled) {
+	TraceEnabled = enabled;
+}
+
+bool Enabled() {
+	return TraceEnabled.load(std::memory_order_relaxed);
+}
+
+void SetCapacity(int capacity) {
+	auto &buffer = Instance();
+	auto lock = std::unique_lock(buffer.mutex);
+	buffer.capacity = std::max(capacity, 1);
+	buffer.events.clear();
+	buffer.next = 0;
+	buffer.full = false;
+}
+
+void Clear() {
+	auto &buffer = Instance();
+	auto lock = std::unique_lock(buffer.mutex);
+	buffer.events.clear();
+	buffer.next = 0;
+	buffer.full = false;
+}
+
+void Record(
+		const char *name,
+		crl::profile_time start,
+		crl::profile_time duration) {
+	if (!Enabled()) {
+		return;
+	}
+	const auto event = Event{
+		.name = name,
+		.start = start,
+		.duration = duration,
+		.thread = CurrentThread(),
+	};
+	auto &buffer = Instance();
+	auto lock = std::unique_lock(buffer.mutex);
+	if (!buffer.full) {
+		buffer.events.push_back(event);
+		if (int(buffer.events.size()) == buffer.capacity) {
+			buffer.full = true;
+		}
+	} else {
+		buffer.events[buffer.next] = event;
+		buffer.next = (buffer.next + 1) % buffer.capacity;
+	}
+}
+
+QByteArray ChromeJson() {
+	auto &buffer = Instance();
+	auto events = std::vector<Event>();
+	{
+		auto lock = std::unique_lock(buffer.mutex);
+		events.reserve(buffer.events.size());
+		events.insert(
+			end(events),
+			begin(buffer.events) + buffer.next,
+			end(buffer.events));
+		events.insert(
+			end(events),
+			begin(buffer.events),
+			begin(buffer.events) + buffer.next);
+	}
+	const auto pid = QByteArray::number(QCoreApplication::applicationPid());
+	auto result = QByteArray("{\"traceEvents\":[");
+	auto first = true;
+	for (const auto &event : events) {
+		if (!first) {
+			result.append(',');
+		}
+		first = false;
+		result.append("\n{\"name\":\"").append(Escaped(event.name));
+		result.append("\",\"cat\":\"ui\",\"ph\":\"X\",\"ts\":");
+		result.append(QByteArray::number(event.start));
+		result.append(",\"dur\":").append(QByteArray::number(event.duration));
+		result.append(",\"pid\":").append(pid);
+		result.append(",\"tid\":").append(QByteArray::number(event.thread));
+		result.append('}');
+	}
+	result.append("\n],\"displayTimeUnit\":\"ms\"}\n");
+	return result;
+}
+
+} // namespace Ui::Trace
@@ -0,0 +1,66 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+#include <crl/crl_time.h>
+
+// Scoped trace markers for the hot paths, compiled out unless lib_ui is
+// configured with -DLIB_UI_ENABLE_TRACING=ON. The host application may
+// use the same API for its own spans regardless of that option.
+//
+// Names must be string literals (or otherwise live forever).
+
+namespace Ui::Trace {
+
+// Events are recorded only while enabled, into a ring buffer
+// keeping the last 'capacity' events, 64K by default.
+void SetEnabled(bool enabled);
+[[nodiscard]] bool Enabled();
+void SetCapacity(int capacity);
+void Clear();
+
+// Adds a complete span, times are from crl::profile().
+void Record(
+	const char *name,
+	crl::profile_time start,
+	crl::profile_time duration);
+
+// Dumps the recorded events in the Chrome trace-event JSON format,
+// loadable by chrome://tracing and Perfetto.
+[[nodiscard]] QByteArray ChromeJson();
+
+class Scope final {
+public:
+	explicit Scope(const char *name)
+	: _name(Enabled() ? name : nullptr)
+	, _start(_name ? crl::profile() : 0) {
+	}
+	Scope(const Scope &other) = delete;
+	Scope &operator=(const Scope &other) = delete;
+	~Scope() {
+		if (_name) {
+			Record(_name, _start, crl::profile() - _start);
+		}
+	}
+
+private:
+	const char *_name = nullptr;
+	crl::profile_time _start = 0;
+
+};
+
+} // namespace Ui::Trace
+
+#ifdef LIB_UI_ENABLE_TRACING
+#define UI_TRACE_CONCAT_IMPL(a, b) a##b
+#define UI_TRACE_CONCAT(a, b) UI_TRACE_CONCAT_IMPL(a, b)
+#define UI_TRACE_SCOPE(name) \
+	const auto UI_TRACE_CONCAT(ui_trace_scope_, __LINE__) \
+		= ::Ui::Trace::Scope(name)
+#else // LIB_UI_ENABLE_TRACING
+#define UI_TRACE_SCOPE(name) do {} while (false)
+#endif // LIB_UI_ENABLE_TRACING
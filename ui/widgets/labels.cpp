@@ -29,6 +29,11 @@
 namespace Ui {
 namespace {
 
+constexpr auto kDefaultUnloadMargin = 1024;
+
+std::optional<int> DefaultUnloadMargin;
+FlatLabel::UnloadStats Unloaded;
+
 TextParseOptions _labelOptions = {
 	TextParseMultiline, // flags
 	0, // maxw
@@ -264,6 +269,7 @@ void FlatLabel::init() {
 }
 
 void FlatLabel::textUpdated() {
+	_unloaded = false;
 	accessibilityNameChanged();
 	refreshSize();
 	setMouseTracking(_selectable || _text.hasLinks());
@@ -323,6 +329,41 @@ int FlatLabel::resizeGetHeight(int newWidth) {
 	return countTextHeight(_textWidth);
 }
 
+void FlatLabel::setUnloadMargin(int margin) {
+	_unloadMargin = margin;
+}
+
+void FlatLabel::SetDefaultUnloadMargin(int margin) {
+	DefaultUnloadMargin = margin;
+}
+
+FlatLabel::UnloadStats FlatLabel::UnloadStatistics() {
+	return Unloaded;
+}
+
+void FlatLabel::visibleDistanceUpdated(int visibleTop, int visibleBottom) {
+	const auto margin = _unloadMargin
+		? *_unloadMargin
+		: DefaultUnloadMargin
+		? *DefaultUnloadMargin
+		: style::ConvertScale(kDefaultUnloadMargin);
+	if (margin < 0 || !_text.hasPersistentAnimation()) {
+		return;
+	}
+	const auto away = (visibleBottom < -margin)
+		|| (visibleTop > height() + margin);
+	if (away == _unloaded) {
+		return;
+	} else if (away) {
+		// Objects are loaded back lazily by the next paint.
+		_text.unloadPersistentAnimation();
+		++Unloaded.unloads;
+	} else {
+		++Unloaded.returns;
+	}
+	_unloaded = away;
+}
+
 int FlatLabel::textMaxWidth() const {
 	return _text.maxWidth();
 }
@@ -336,18 +377,10 @@ int FlatLabel::countTextWidth(int newWidth) const {
 	if (newWidth > 0
 		&& newWidth < _text.maxWidth()
 		&& _tryMakeSimilarLines) {
-		auto large = newWidth;
-		auto small = std::max(newWidth / 2, _st.minWidth);
-		const auto largeHeight = _text.countHeight(large, _breakEverywhere);
-		while (large - small > 1) {
-			const auto middle = (large + small) / 2;
-			if (largeHeight == _text.countHeight(middle, _breakEverywhere)) {
-				large = middle;
-			} else {
-				small = middle;
-			}
-		}
-		return large;
+		return _text.countBalancedWidth(
+			std::max(newWidth / 2, _st.minWidth),
+			newWidth,
+			_breakEverywhere);
 	}
 	return available;
 }
@@ -158,6 +158,17 @@ public:
 		_animationsPausedCallback = std::move(callback);
 	}
 
+	// Custom emoji and spoilers are unloaded when the label is farther
+	// than the margin from the visible area, negative margin disables it.
+	void setUnloadMargin(int margin);
+	static void SetDefaultUnloadMargin(int margin);
+
+	struct UnloadStats {
+		int64 unloads = 0;
+		int64 returns = 0; // Back in range, loaded by the next paint.
+	};
+	[[nodiscard]] static UnloadStats UnloadStatistics();
+
 	[[nodiscard]] int textMaxWidth() const;
 	QMargins getMargins() const override;
 
@@ -210,6 +221,9 @@ protected:
 	void touchEvent(QTouchEvent *e);
 
 	int resizeGetHeight(int newWidth) override;
+	void visibleDistanceUpdated(
+		int visibleTop,
+		int visibleBottom) override;
 
 	void copySelectedText();
 	void copyContextText();
@@ -249,6 +263,8 @@ private:
 	int _fullTextHeight = 0;
 	bool _breakEverywhere = false;
 	bool _tryMakeSimilarLines = false;
+	std::optional<int> _unloadMargin;
+	bool _unloaded = false;
 
 	style::cursor _cursor = style::cur_default;
 	bool _selectable = false;
@@ -6,6 +6,7 @@
 //
 #include "ui/widgets/rp_window.h"
 
+#include "ui/effects/animations.h"
 #include "ui/platform/ui_platform_window.h"
 
 namespace Ui {
@@ -17,6 +18,15 @@ RpWindow::RpWindow(QWidget *parent)
 
 	_helper->initInWindow(this);
 	hide();
+
+	events(
+	) | rpl::filter([=](not_null<QEvent*> e) {
+		return (e->type() == QEvent::WindowActivate);
+	}) | rpl::on_next([=] {
+		if (const auto handle = windowHandle()) {
+			Animations::PaceByWindow(handle);
+		}
+	}, lifetime());
 }
 
 RpWindow::~RpWindow() = default;